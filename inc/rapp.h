@@ -25,11 +25,19 @@ namespace rapp {
 
 	struct App;
 	struct AppData;
+	struct TaskConfig;
 
 	typedef int(*ConsoleFn)(App* _app, void* _userData, int _argc, char const* const* _argv);
 	typedef void(*ThreadFn)(void* _userData);
 	typedef bool(*DialogFn)(void* _userData);
 	typedef void(*TaskFn)(void* _userData, uint32_t _start, uint32_t _end);
+	typedef void(*TaskFnEx)(void* _userData, uint32_t _start, uint32_t _end, uint32_t _worker);
+	typedef void(*ReduceFn)(void* _partial, const void* _data, uint32_t _start, uint32_t _end, void* _userData);
+	typedef void(*CombineFn)(void* _dst, const void* _src, void* _userData);
+	typedef bool(*LessFn)(const void* _a, const void* _b, void* _userData);
+	typedef bool(*PredicateFn)(const void* _item, void* _userData);
+	typedef void(*FileReadFn)(void* _userData, const void* _data, uint32_t _size, int32_t _result);
+	typedef void(*FileChunkFn)(void* _userData, const void* _data, uint32_t _size, uint64_t _offset, int32_t _result);
 
 	struct App
 	{
@@ -39,6 +47,8 @@ namespace rapp {
 		uint32_t		m_width;
 		uint32_t		m_height;
 		uint32_t		m_frameRate;
+		uint32_t		m_framesInFlight;
+		uint32_t		m_snapshotSize;
 		AppData*		m_data;
 		bool			m_resetView;
 
@@ -52,6 +62,7 @@ namespace rapp {
 		virtual void	resume()			= 0;
 		virtual void	update(float _time)	= 0;
 		virtual void	draw(float _alpha)	= 0;
+		virtual void	writeSnapshot(void* _snapshot) { (void)_snapshot; } // pipelined mode only, called after update
 		virtual void	drawGUI() {}
 		virtual void	shutDown()			= 0;
 		virtual bool	isGUImode() { return true; }
@@ -66,9 +77,10 @@ namespace rapp {
 	/// Initializes rapp library.
 	///
 	/// @param[in] _libInterface   : Optional pointer to rtm library interface (alloc, log)
+	/// @param[in] _taskConfig     : Optional task system configuration, defaults are used if null.
 	///
 	/// @returns true on success
-	void init(rtmLibInterface* _libInterface = 0);
+	void init(rtmLibInterface* _libInterface = 0, const TaskConfig* _taskConfig = 0);
 
 	/// Shuts down rapp library and release resources.
 	void shutDown();
@@ -101,6 +113,25 @@ namespace rapp {
 	/// @param[in] _argv           : Arguments list.
 	int appRun(App* _app, int _argc, const char* const* _argv);
 
+	/// Enables pipelined mode, update of the next frame runs on a worker thread while current frame
+	/// is drawn on app thread. After update App::writeSnapshot is called to copy state needed for drawing
+	/// into a snapshot buffer, App::draw and App::drawGUI should only read state through appGetSnapshot.
+	/// App::update then runs on a worker thread, it must not call bgfx, open dialogs or touch any other
+	/// state used by the app thread, debug builds assert on rapp functions meant for the app thread.
+	/// Can be called from App::init or later on app thread, takes effect at the start of the next frame.
+	///
+	/// @param[in] _app            : Application to change mode of.
+	/// @param[in] _framesInFlight : Frames in flight, 2 for double and 3 for triple buffered snapshots, 1 disables pipelining.
+	/// @param[in] _snapshotSize   : Size of app state snapshot, in bytes.
+	void appSetPipelined(App* _app, uint32_t _framesInFlight, uint32_t _snapshotSize);
+
+	/// Returns snapshot of the frame being drawn, valid in App::draw and App::drawGUI in pipelined mode.
+	///
+	/// @param[in] _app            : Application to get snapshot of.
+	///
+	/// @returns Snapshot written by App::writeSnapshot or null if app is not pipelined.
+	const void* appGetSnapshot(App* _app);
+
 	/// Runs a function on main thread
 	///
 	/// @param[in] _fn             : Function to run.
@@ -567,17 +598,76 @@ namespace rapp {
 	#define RAPP_TASK_STATUS_PENDING	0
 	#define RAPP_TASK_STATUS_RUNNING	1
 	#define RAPP_TASK_STATUS_COMPLETE	2
+	#define RAPP_TASK_STATUS_CANCELLED	3
 
-	struct TaskHandle { uintptr_t  idx; };
+	#define RAPP_TASK_THREAD_MAIN		0xffffffff
+	#define RAPP_TASK_THREAD_APP		0xfffffffe
+	#define RAPP_TASK_THREAD_IO			0xfffffffc	// Least busy thread of the blocking I/O pool
+
+	#define RAPP_TASK_MAX_THREADS		64
+
+	#define RAPP_TASK_WAIT_SLEEP		0	// Brief enkiTS backoff then sleep, saves power
+	#define RAPP_TASK_WAIT_SPIN			1	// Spin for new work before sleeping, lower wake latency
+
+	struct TaskConfig
+	{
+		uint32_t	m_numWorkers		= 0;	// Worker threads to create, 0 = hardware threads minus reserved cores
+		uint32_t	m_numReservedCores	= 0;	// Cores left to main and app threads, 0 = scheduler default
+		uint64_t	m_affinityMask		= 0;	// CPUs workers are pinned to, one per worker, 0 = no pinning
+		uint32_t	m_waitPolicy		= RAPP_TASK_WAIT_SLEEP;
+		uint32_t	m_spinTimeUs		= 50;	// Spin time for RAPP_TASK_WAIT_SPIN policy, in microseconds
+		uint32_t	m_numIoThreads		= 2;	// Threads running blocking tasks, in addition to workers, at least one
+		bool		m_serial			= false;	// Run task sets inline on submitting thread, in submission order
+		bool		m_recordTimings		= false;	// Record per task timings, see taskGetTimings
+	};
+
+	struct TaskHandle { uint32_t idx; };
+	inline bool isValid(TaskHandle _handle) { return UINT32_MAX != _handle.idx; }
+
+	struct TaskPoolStats
+	{
+		uint32_t	m_capacity;			// Number of task objects currently backed by slabs
+		uint32_t	m_numLive;			// Number of tasks created and not yet released
+		uint32_t	m_numAllocations;	// Heap allocations made by the pool since init, constant in steady state
+	};
+
+	struct TaskThreadStats
+	{
+		uint64_t	m_numExecuted;		// Task partitions and pinned tasks executed on the thread
+		uint64_t	m_numRemote;		// Partitions executed on a thread other than the submitting one
+		uint64_t	m_numSubmitted;		// Tasks submitted from the thread
+		uint64_t	m_numPipeFull;		// Submissions that found the task pipe full and ran partitions inline
+		float		m_timeBusy;			// Time spent executing tasks, in milliseconds
+		float		m_timeWaiting;		// Time spent waiting on tasks to complete, in milliseconds
+		float		m_timeSuspended;	// Time spent suspended waiting for new tasks, in milliseconds
+	};
+
+	struct TaskStats
+	{
+		uint32_t		m_numThreads;
+		uint64_t		m_numSubmitted;
+		uint64_t		m_numPipeFull;
+		TaskThreadStats	m_threads[RAPP_TASK_MAX_THREADS];
+	};
+
+	struct TaskTiming
+	{
+		const char*	m_name;
+		uint64_t	m_numSerial;
+		float		m_timeSerial;		// Total execution time of inline runs in serial mode, in milliseconds
+		uint64_t	m_numParallel;
+		float		m_timeParallel;		// Total time from submission to completion in parallel mode, in milliseconds
+	};
 
 	/// Creates a task to run in a task system.
 	/// 
 	/// @param[in] _func           : Function to run.
 	/// @param[in] _userData       : User data to provide to function the call as argument.
 	/// @param[in] _delteOnFinish  : Whether to delete the task once it is finished.
+	/// @param[in] _name           : Optional static name of the task, used as profiler scope label.
 	///
-	/// @returns Handle for the created task.
-	TaskHandle taskCreate(TaskFn  _func, void* _userData = 0, bool _deleteOnFinish = true);
+	/// @returns Handle for the created task, invalid if task pool is exhausted or out of memory.
+	TaskHandle taskCreate(TaskFn  _func, void* _userData = 0, bool _deleteOnFinish = true, const char* _name = 0);
 
 	/// Creates a task group for linearly data stored.
 	/// 
@@ -586,11 +676,56 @@ namespace rapp {
 	/// @param[in] _dataStride     : Stride between two blocks of data.
 	/// @param[in] _numTasks       : Number of tasks to run, implicitly defining data size.
 	/// @param[in] _delteOnFinish  : Whether to delete the task once it is finished.
+	/// @param[in] _name           : Optional static name of the task, used as profiler scope label.
 	///
-	/// @returns Handle for the created task.
-	TaskHandle taskCreateGroup(TaskFn _func, void* _userData, uint32_t _dataStride, uint32_t _numTasks, bool _deleteOnFinish = true);
+	/// @returns Handle for the created task, invalid if task pool is exhausted or out of memory.
+	TaskHandle taskCreateGroup(TaskFn _func, void* _userData, uint32_t _dataStride, uint32_t _numTasks, bool _deleteOnFinish = true, const char* _name = 0);
 
-	/// Destroys a task.
+	/// Creates a task pinned to a thread, runs on that thread once scheduled with taskRun.
+	/// Completion can be waited on with taskWait, main thread is woken up as soon as the task is run.
+	/// On platforms without main loop wake up support, tasks pinned to main thread should be run from app thread.
+	/// Tasks that block (file, pipe or socket I/O) should be pinned to RAPP_TASK_THREAD_IO, they then run
+	/// on a bounded pool of I/O threads and don't take workers away from CPU bound tasks.
+	/// 
+	/// @param[in] _func           : Function to run.
+	/// @param[in] _userData       : User data to provide to function the call as argument.
+	/// @param[in] _thread         : RAPP_TASK_THREAD_MAIN, RAPP_TASK_THREAD_APP, RAPP_TASK_THREAD_IO or index of a worker thread.
+	/// @param[in] _delteOnFinish  : Whether to delete the task once it is finished.
+	/// @param[in] _name           : Optional static name of the task, used as profiler scope label.
+	///
+	/// @returns Handle for the created task, invalid if task pool is exhausted or out of memory.
+	TaskHandle taskCreatePinned(ThreadFn _func, void* _userData, uint32_t _thread, bool _deleteOnFinish = true, const char* _name = 0);
+
+	/// Creates a parallel for task over linearly stored data.
+	/// Unlike task group, function receives _userData already offset to the first element of the
+	/// range (_data + _start * _dataStride), with zero stride it receives _data unchanged.
+	/// Partition size is picked adaptively from per item cost measured in previous runs of the same function.
+	/// 
+	/// @param[in] _func           : Function to run on ranges of elements.
+	/// @param[in] _data           : Pointer to the first element.
+	/// @param[in] _dataStride     : Stride between two elements, in bytes.
+	/// @param[in] _count          : Number of elements to process.
+	/// @param[in] _minGrain       : Optional minimum number of elements per partition.
+	/// @param[in] _delteOnFinish  : Whether to delete the task once it is finished.
+	/// @param[in] _name           : Optional static name of the task, used as profiler scope label.
+	///
+	/// @returns Handle for the created task.
+	TaskHandle taskCreateParallelFor(TaskFn _func, void* _data, uint32_t _dataStride, uint32_t _count, uint32_t _minGrain = 0, bool _deleteOnFinish = true, const char* _name = 0);
+
+	/// Variants of task creation functions taking a function that also receives index of the worker
+	/// running it, in range [0, taskGetNumWorkers()). Index is stable for the thread, so it can be used
+	/// to address per worker partial results without atomics.
+	TaskHandle taskCreate(TaskFnEx _func, void* _userData = 0, bool _deleteOnFinish = true, const char* _name = 0);
+	TaskHandle taskCreateGroup(TaskFnEx _func, void* _userData, uint32_t _dataStride, uint32_t _numTasks, bool _deleteOnFinish = true, const char* _name = 0);
+	TaskHandle taskCreateParallelFor(TaskFnEx _func, void* _data, uint32_t _dataStride, uint32_t _count, uint32_t _minGrain = 0, bool _deleteOnFinish = true, const char* _name = 0);
+
+	/// Returns number of thread indices of the task system, including main, app, timer, file and
+	/// I/O threads that rarely run compute work. Worker indices passed to TaskFnEx functions are
+	/// smaller than this value, use it to size per thread data, not to choose partition counts.
+	uint32_t taskGetNumWorkers();
+
+	/// Destroys a task. Launched tasks created with _deleteOnFinish are released by the scheduler
+	/// and must not be destroyed.
 	/// 
 	/// @param[in] _task           : Handle for the taks to destroy.
 	void taskDestroy(TaskHandle _task);
@@ -605,13 +740,337 @@ namespace rapp {
 	/// @param[in] _task           : Task to wait on.
 	void taskWait(TaskHandle _task);
 
-	/// Returns current status of the task.
+	/// Runs a blocking function on the I/O pool and waits for it, calling thread executes
+	/// other tasks meanwhile. Use it for blocking calls inside CPU bound tasks.
+	/// 
+	/// @param[in] _func           : Function to run.
+	/// @param[in] _userData       : User data to provide to function the call as argument.
+	void taskRunBlocking(ThreadFn _func, void* _userData);
+
+	/// Run a batch of tasks. Caller makes a single submission of a launcher task whose partitions submit
+	/// the tasks from worker threads, each task is still added to the scheduler on its own and may wake
+	/// workers. Main and app threads are woken once per partition instead of once per task.
+	/// Returns right away, waiting on a task of the batch first waits for the launcher to submit it.
+	/// 
+	/// @param[in] _tasks          : Tasks to run.
+	/// @param[in] _count          : Number of tasks.
+	void taskRunBatch(const TaskHandle* _tasks, uint32_t _count);
+
+	/// Wait on all tasks to finish, calling thread executes other tasks while waiting.
+	/// 
+	/// @param[in] _tasks          : Tasks to wait on.
+	/// @param[in] _count          : Number of tasks.
+	void taskWaitAll(const TaskHandle* _tasks, uint32_t _count);
+
+	/// Wait on any of the tasks to finish, calling thread executes other tasks while waiting and
+	/// sleeps when there are none, it's woken by completion of any of the tasks.
+	/// 
+	/// @param[in] _tasks          : Tasks to wait on.
+	/// @param[in] _count          : Number of tasks.
+	/// 
+	/// @returns index of a finished task or UINT32_MAX if there are no tasks.
+	uint32_t taskWaitAny(const TaskHandle* _tasks, uint32_t _count);
+
+	/// Returns current status of the task, pending until the first partition starts running.
+	/// Cancelled status is reported once a cancelled task has finished its already running partitions.
+	/// Handles of tasks that were already released (destroyed or deleted on finish) report complete status.
 	/// 
 	/// @param[in] _task           : Task to get status of.
 	///
 	/// @returns Status of the task.
 	uint32_t taskStatus(TaskHandle _task);
 
+	/// Cancels a task, partitions that have not started yet are dropped.
+	/// Running partitions can poll taskIsCancelled to stop early. Task still completes, so it can be
+	/// waited on and its continuations are launched. Has no effect on a task that already completed
+	/// or on tasks returned by file functions, those always run.
+	///
+	/// @param[in] _task           : Task to cancel.
+	void taskCancel(TaskHandle _task);
+
+	/// Cancels all the user tasks created so far, tasks created by the framework (file callbacks,
+	/// pipelined update) still run. Called when switching apps to drop speculative work of the app
+	/// being switched away from. Tasks created afterwards are not affected.
+	void taskCancelAll();
+
+	/// Sets task deadline, partitions that have not started before it passes are dropped.
+	///
+	/// @param[in] _task           : Task to set deadline for.
+	/// @param[in] _seconds        : Time from now, in seconds.
+	void taskSetDeadline(TaskHandle _task, float _seconds);
+
+	/// Returns true if the task running on calling thread was cancelled or its deadline passed.
+	/// Long running task functions should poll it and return early.
+	bool taskIsCancelled();
+
+	/// Creates a continuation task, launched by the scheduler once parent task completes.
+	/// Continuation is launched right away if parent is already complete, it must not be run with taskRun.
+	/// Continuations of a task destroyed before it was run are never launched.
+	///
+	/// @param[in] _parent         : Task to continue.
+	/// @param[in] _func           : Function to run.
+	/// @param[in] _userData       : User data to provide to function the call as argument.
+	/// @param[in] _delteOnFinish  : Whether to delete the task once it is finished.
+	/// @param[in] _name           : Optional static name of the task, used as profiler scope label.
+	///
+	/// @returns Handle for the created task, invalid if task pool is exhausted or out of memory.
+	TaskHandle taskThen(TaskHandle _parent, TaskFn _func, void* _userData = 0, bool _deleteOnFinish = true, const char* _name = 0);
+
+	/// Calls a function on app thread at the start of the frame after parent task completes.
+	///
+	/// @param[in] _parent         : Task to wait for.
+	/// @param[in] _func           : Function to call.
+	/// @param[in] _userData       : User data to provide to function the call as argument.
+	///
+	/// @returns true if callback was queued, false if task pool is exhausted or out of memory.
+	bool taskThenOnAppThread(TaskHandle _parent, ThreadFn _func, void* _userData = 0);
+
+	/// Retrieves task object pool statistics.
+	///
+	/// @param[in,out] _stats      : Pool statistics structure reference.
+	void taskGetPoolStats(TaskPoolStats& _stats);
+
+	/// Switches serial mode. In serial mode task sets, task graphs and parallel algorithms run inline on
+	/// the submitting thread in submission order, pinned tasks still run on their threads.
+	/// Comparing serial timings against parallel ones tells work cost apart from scheduling cost.
+	///
+	/// @param[in] _serial         : True to run tasks inline, false for parallel execution.
+	void taskSetSerial(bool _serial);
+
+	/// Enables recording of per task timings, keyed by task name.
+	///
+	/// @param[in] _record         : True to record timings.
+	void taskSetRecordTimings(bool _record);
+
+	/// Retrieves recorded per task timings.
+	///
+	/// @param[out] _timings       : Array to fill with timings.
+	/// @param[in] _maxTimings     : Size of the array.
+	///
+	/// @returns Number of timings written.
+	uint32_t taskGetTimings(TaskTiming* _timings, uint32_t _maxTimings);
+
+	/// Resets recorded per task timings.
+	void taskResetTimings();
+
+	/// Overrides task configuration from command line arguments.
+	/// Recognized: --task-workers=N, --task-reserve=N, --task-affinity=MASK, --task-wait=spin|sleep, --task-io=N,
+	/// --task-serial and --task-timings
+	///
+	/// @param[in,out] _config     : Task configuration to modify.
+	/// @param[in] _argc           : Number of command line arguments.
+	/// @param[in] _argv           : Command line arguments.
+	void taskConfigParse(TaskConfig& _config, int32_t _argc, const char* const* _argv);
+
+	/// Retrieves configuration the task system was initialized with.
+	///
+	/// @param[in,out] _config     : Task configuration reference.
+	void taskGetConfig(TaskConfig& _config);
+
+	/// Retrieves task scheduler statistics, accumulated since init.
+	///
+	/// @param[in,out] _stats      : Statistics structure reference.
+	void taskGetStats(TaskStats& _stats);
+
+	struct TaskGraphHandle { uintptr_t idx; };
+	inline bool isValid(TaskGraphHandle _handle) { return 0 != _handle.idx; }
+
+	/// Creates an empty task graph. Nodes and edges are declared once and the whole
+	/// graph can then be launched repeatedly (e.g. once per frame) with a single call.
+	///
+	/// @returns Handle for the created task graph.
+	TaskGraphHandle taskGraphCreate();
+
+	/// Destroys a task graph, waits for it to finish first if it is running.
+	///
+	/// @param[in] _graph          : Task graph to destroy.
+	void taskGraphDestroy(TaskGraphHandle _graph);
+
+	/// Adds a node to the task graph.
+	///
+	/// @param[in] _graph          : Task graph to add node to.
+	/// @param[in] _func           : Function to run, called with ranges in [0, _numTasks).
+	/// @param[in] _userData       : User data to provide to function the call as argument.
+	/// @param[in] _numTasks       : Number of tasks (range size) of the node.
+	/// @param[in] _name           : Optional static name of the node, used as profiler scope label.
+	///
+	/// @returns Index of the node in the graph or UINT32_MAX if graph is full.
+	uint32_t taskGraphAddNode(TaskGraphHandle _graph, TaskFn _func, void* _userData = 0, uint32_t _numTasks = 1, const char* _name = 0);
+
+	/// Adds a dependency edge between two nodes, node _to runs only after node _from has completed.
+	///
+	/// @param[in] _graph          : Task graph to add edge to.
+	/// @param[in] _from           : Index of the node to run first.
+	/// @param[in] _to             : Index of the dependent node.
+	void taskGraphAddEdge(TaskGraphHandle _graph, uint32_t _from, uint32_t _to);
+
+	/// Launches all nodes of the task graph, returns immediately. Nodes are started
+	/// by the scheduler as their dependencies complete.
+	///
+	/// @param[in] _graph          : Task graph to run.
+	void taskGraphRun(TaskGraphHandle _graph);
+
+	/// Waits on all nodes of the task graph to finish.
+	///
+	/// @param[in] _graph          : Task graph to wait on.
+	void taskGraphWait(TaskGraphHandle _graph);
+
+	/// Returns current status of the task graph.
+	///
+	/// @param[in] _graph          : Task graph to get status of.
+	///
+	/// @returns Status of the task graph.
+	uint32_t taskGraphStatus(TaskGraphHandle _graph);
+
+	// ------------------------------------------------
+	/// Timer functions
+	// ------------------------------------------------
+
+	struct TimerHandle { uint32_t idx; };
+	inline bool isValid(TimerHandle _handle) { return UINT32_MAX != _handle.idx; }
+
+	/// Runs a task once after a delay. Timers are kept in a timer wheel advanced by a
+	/// dedicated thread, tasks are submitted even if app thread is busy or blocked.
+	///
+	/// @param[in] _delay          : Delay in seconds, rounded to RAPP_TIMER_TICK_US.
+	/// @param[in] _func           : Task function, a new task is created when timer fires.
+	/// @param[in] _userData       : User data to provide to task function as argument.
+	/// @param[in] _name           : Optional task name, used for profiling.
+	///
+	/// @returns Handle of the timer.
+	TimerHandle taskRunAfter(float _delay, TaskFn _func, void* _userData = 0, const char* _name = 0);
+
+	/// Runs a task periodically, first time after one period.
+	///
+	/// @param[in] _period         : Period in seconds, rounded to RAPP_TIMER_TICK_US.
+	/// @param[in] _func           : Task function, a new task is created each time timer fires.
+	/// @param[in] _userData       : User data to provide to task function as argument.
+	/// @param[in] _name           : Optional task name, used for profiling.
+	///
+	/// @returns Handle of the timer.
+	TimerHandle taskRunEvery(float _period, TaskFn _func, void* _userData = 0, const char* _name = 0);
+
+	/// Runs a task once a number of frames have ended, submitted from app thread at the end of the frame.
+	///
+	/// @param[in] _frames         : Number of frames to wait for.
+	/// @param[in] _func           : Task function, a new task is created when timer fires.
+	/// @param[in] _userData       : User data to provide to task function as argument.
+	/// @param[in] _name           : Optional task name, used for profiling.
+	///
+	/// @returns Handle of the timer.
+	TimerHandle taskRunInFrames(uint32_t _frames, TaskFn _func, void* _userData = 0, const char* _name = 0);
+
+	/// Cancels a timer, task of a timer that's firing at the moment may still run.
+	///
+	/// @param[in] _timer          : Timer to cancel.
+	///
+	/// @returns true if timer would have fired again.
+	bool timerCancel(TimerHandle _timer);
+
+	// ------------------------------------------------
+	/// Asynchronous file functions
+	// ------------------------------------------------
+
+	/// Reads a range of a file without blocking the calling thread. Reads use io_uring on Linux
+	/// and I/O thread pool elsewhere, callback runs as a task on a worker once data is read.
+	/// Returned task can be waited on or continued with taskThen, it's deleted once finished.
+	///
+	/// @param[in] _path           : Path of the file to read.
+	/// @param[in] _offset         : Offset in file to read from, in bytes.
+	/// @param[in] _size           : Number of bytes to read, 0 reads to the end of the file.
+	/// @param[in] _func           : Callback receiving data, valid only during the call, and 0 or negative error code.
+	/// @param[in] _userData       : User data to provide to callback as argument.
+	///
+	/// @returns Handle of the callback task, invalid if it couldn't be created and callback won't be called.
+	TaskHandle fileReadAsync(const char* _path, uint64_t _offset, uint32_t _size, FileReadFn _func, void* _userData = 0);
+
+	/// Streams a file in chunks, next chunks are read while callback processes the current one.
+	/// Callbacks run as tasks on workers, one at a time and in file order.
+	///
+	/// @param[in] _path           : Path of the file to read.
+	/// @param[in] _chunkSize      : Size of a chunk, in bytes.
+	/// @param[in] _numChunks      : Number of chunk buffers, up to that many reads are in flight.
+	/// @param[in] _func           : Callback receiving chunk data, valid only during the call, and 0 or negative error code.
+	/// @param[in] _userData       : User data to provide to callback as argument.
+	///
+	/// @returns Handle of a task finishing after the last chunk callback, invalid if it couldn't be created and callback won't be called.
+	TaskHandle fileStream(const char* _path, uint32_t _chunkSize, uint32_t _numChunks, FileChunkFn _func, void* _userData = 0);
+
+	// ------------------------------------------------
+	/// Frame memory functions
+	// ------------------------------------------------
+
+	/// Allocates scratch memory from calling thread's linear arena, can be called from tasks.
+	/// Arena belongs to the thread, not to the task. Memory stays valid until the frames in flight after
+	/// the one it was allocated in have ended (RAPP_PIPELINE_MAX_FRAMES frames, ended by Command::Frame on
+	/// app thread), so tasks and pipelined updates running across a frame boundary can keep using it.
+	/// It must not be held longer, it's never freed explicitly. Arena grows to the frame high water mark,
+	/// steady state frames make no heap allocations.
+	///
+	/// @param[in] _size           : Size of allocation in bytes.
+	/// @param[in] _align          : Alignment of allocation, power of two.
+	///
+	/// @returns Pointer to allocated memory, null if out of memory.
+	void* frameAlloc(uint32_t _size, uint32_t _align = 16);
+
+	// ------------------------------------------------
+	/// Parallel algorithms
+	// ------------------------------------------------
+
+	// Scratch memory is taken from the calling thread's frame arena (see frameAlloc), if it can't
+	// be allocated the algorithm runs serially on the calling thread.
+
+	/// Reduces an array in parallel, each worker thread reduces blocks into its own partial result.
+	/// Partial results are combined on the calling thread, combine function has to be associative and commutative.
+	///
+	/// @param[in] _data           : Data to reduce, passed to reduce function.
+	/// @param[in] _count          : Number of items to reduce.
+	/// @param[in,out] _result     : Identity value on input, reduced value on output.
+	/// @param[in] _resultSize     : Size of result, in bytes.
+	/// @param[in] _reduce         : Function reducing items in range [_start, _end) into partial result.
+	/// @param[in] _combine        : Function combining a partial result into another (_dst = _dst op _src).
+	/// @param[in] _userData       : User data to provide to functions as argument.
+	void parallelReduce(const void* _data, uint32_t _count, void* _result, uint32_t _resultSize, ReduceFn _reduce, CombineFn _combine, void* _userData = 0);
+
+	/// Computes inclusive prefix scan in parallel, input and output can be the same array.
+	/// Combine function has to be associative.
+	///
+	/// @param[in] _in             : Input items.
+	/// @param[out] _out           : Output items.
+	/// @param[in] _stride         : Size of an item in bytes, up to RAPP_PARALLEL_MAX_STRIDE.
+	/// @param[in] _count          : Number of items.
+	/// @param[in] _combine        : Function combining two items (_dst = _dst op _src).
+	/// @param[in] _userData       : User data to provide to combine function as argument.
+	void parallelInclusiveScan(const void* _in, void* _out, uint32_t _stride, uint32_t _count, CombineFn _combine, void* _userData = 0);
+
+	/// Sorts integer keys in parallel using LSD radix sort, optional values are moved along with keys.
+	///
+	/// @param[in,out] _keys       : Keys to sort.
+	/// @param[in] _count          : Number of keys.
+	/// @param[in,out] _values     : Optional values to reorder together with keys.
+	void parallelSort(uint32_t* _keys, uint32_t _count, uint32_t* _values = 0);
+	void parallelSort(uint64_t* _keys, uint32_t _count, uint32_t* _values = 0);
+
+	/// Sorts items in parallel using a stable merge sort.
+	///
+	/// @param[in,out] _data       : Items to sort.
+	/// @param[in] _stride         : Size of an item in bytes.
+	/// @param[in] _count          : Number of items.
+	/// @param[in] _less           : Function returning true if first item is ordered before second one.
+	/// @param[in] _userData       : User data to provide to compare function as argument.
+	void parallelSort(void* _data, uint32_t _stride, uint32_t _count, LessFn _less, void* _userData = 0);
+
+	/// Stable partition in parallel, items satisfying predicate are moved to the front of the array.
+	///
+	/// @param[in,out] _data       : Items to partition.
+	/// @param[in] _stride         : Size of an item in bytes.
+	/// @param[in] _count          : Number of items.
+	/// @param[in] _predicate      : Predicate function, called once per item.
+	/// @param[in] _userData       : User data to provide to predicate function as argument.
+	///
+	/// @returns Number of items satisfying the predicate.
+	uint32_t parallelPartition(void* _data, uint32_t _stride, uint32_t _count, PredicateFn _predicate, void* _userData = 0);
+
 	// ------------------------------------------------
 	/// Input functions
 	// ------------------------------------------------
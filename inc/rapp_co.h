@@ -0,0 +1,379 @@
+//--------------------------------------------------------------------------//
+/// Copyright 2025 Milos Tosic. All Rights Reserved.                       ///
+/// License: http://www.opensource.org/licenses/BSD-2-Clause               ///
+//--------------------------------------------------------------------------//
+
+#ifndef RTM_RAPP_CO_H
+#define RTM_RAPP_CO_H
+
+// Optional C++20 coroutine front-end for rapp task system.
+//
+//		rapp::co::Task<void> loadLevel(Level* _level)
+//		{
+//			rapp::TaskHandle read = rapp::taskCreate(readFiles, _level);
+//			rapp::taskRun(read);
+//			co_await read;							// resumes on a worker once files are read
+//			co_await rapp::co::nextFrame();			// resumes on app thread at the start of next frame
+//			createResources(_level);
+//		}
+//
+//		rapp::co::spawn(loadLevel(level));
+
+#include <rapp/inc/rapp.h>
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+namespace rapp {
+namespace co {
+
+	template <typename T> class Task;
+
+	namespace detail {
+
+		inline void resume(void* _address)
+		{
+			std::coroutine_handle<>::from_address(_address).resume();
+		}
+
+		inline void resumeTask(void* _address, uint32_t _start, uint32_t _end)
+		{
+			(void)_start;
+			(void)_end;
+			resume(_address);
+		}
+
+		struct PromiseBase
+		{
+			std::coroutine_handle<>	m_continuation;
+			std::atomic<bool>		m_done		= false;
+			bool					m_detached	= false;
+
+			/// Transfers control to the awaiting coroutine, destroys detached coroutines.
+			struct FinalAwaiter
+			{
+				bool await_ready() noexcept { return false; }
+				void await_resume() noexcept {}
+
+				template <typename Promise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> _handle) noexcept
+				{
+					PromiseBase& promise = _handle.promise();
+					std::coroutine_handle<> continuation = promise.m_continuation;
+
+					// owner may destroy the coroutine as soon as it's flagged done, don't touch it after
+					if (promise.m_detached)
+						_handle.destroy();
+					else
+						promise.m_done.store(true, std::memory_order_release);
+
+					return continuation ? continuation : std::noop_coroutine();
+				}
+			};
+
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			FinalAwaiter final_suspend() noexcept { return {}; }
+			void unhandled_exception() noexcept { std::terminate(); }
+		};
+
+		template <typename T>
+		struct Promise : PromiseBase
+		{
+			T m_value {};
+
+			Task<T> get_return_object() noexcept;
+
+			template <typename U>
+			void return_value(U&& _value) { m_value = std::forward<U>(_value); }
+
+			T& result() { return m_value; }
+		};
+
+		template <>
+		struct Promise<void> : PromiseBase
+		{
+			Task<void> get_return_object() noexcept;
+
+			void return_void() noexcept {}
+			void result() {}
+		};
+
+	} // namespace detail
+
+	/// Lazily started coroutine, runs once awaited by another coroutine, started or spawned.
+	template <typename T = void>
+	class Task
+	{
+	public:
+		using promise_type = detail::Promise<T>;
+		using Handle = std::coroutine_handle<promise_type>;
+
+		Task() = default;
+		explicit Task(Handle _handle) : m_handle(_handle) {}
+		Task(Task&& _other) noexcept : m_handle(std::exchange(_other.m_handle, {})) {}
+		Task(const Task&) = delete;
+		Task& operator = (const Task&) = delete;
+
+		Task& operator = (Task&& _other) noexcept
+		{
+			if (this != &_other)
+			{
+				if (m_handle)
+					m_handle.destroy();
+				m_handle = std::exchange(_other.m_handle, {});
+			}
+			return *this;
+		}
+
+		~Task()
+		{
+			if (m_handle)
+				m_handle.destroy();
+		}
+
+		/// Starts the coroutine on a worker thread, poll with isDone.
+		/// Runs it on the calling thread if the task couldn't be created.
+		void start()
+		{
+			TaskHandle task = taskCreate(detail::resumeTask, m_handle.address());
+			if (isValid(task))
+				taskRun(task);
+			else
+				detail::resume(m_handle.address());
+		}
+
+		/// Returns true once the coroutine has finished, safe to call from any thread.
+		bool isDone() const
+		{
+			return m_handle && m_handle.promise().m_done.load(std::memory_order_acquire);
+		}
+
+		/// Returns result of a finished coroutine.
+		decltype(auto) result()
+		{
+			return m_handle.promise().result();
+		}
+
+		/// Awaiting a task starts it and resumes the awaiting coroutine on the thread the task finished on.
+		auto operator co_await() noexcept
+		{
+			struct Awaiter
+			{
+				Handle m_handle;
+
+				bool await_ready() noexcept { return !m_handle || m_handle.done(); }
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> _awaiting) noexcept
+				{
+					m_handle.promise().m_continuation = _awaiting;
+					return m_handle;
+				}
+
+				decltype(auto) await_resume()
+				{
+					if constexpr (std::is_void_v<T>)
+						return;
+					else
+						return std::move(m_handle.promise().result());
+				}
+			};
+
+			return Awaiter { m_handle };
+		}
+
+	private:
+		template <typename U> friend void spawn(Task<U>&& _task);
+
+		Handle m_handle;
+	};
+
+	namespace detail {
+
+		template <typename T>
+		inline Task<T> Promise<T>::get_return_object() noexcept
+		{
+			return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+		}
+
+		inline Task<void> Promise<void>::get_return_object() noexcept
+		{
+			return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+		}
+
+	} // namespace detail
+
+	/// Starts a coroutine on a worker thread and lets it destroy itself when finished.
+	/// Runs it on the calling thread if the task couldn't be created.
+	template <typename T>
+	inline void spawn(Task<T>&& _task)
+	{
+		typename Task<T>::Handle handle = std::exchange(_task.m_handle, {});
+		handle.promise().m_detached = true;
+
+		TaskHandle task = taskCreate(detail::resumeTask, handle.address());
+		if (isValid(task))
+			taskRun(task);
+		else
+			handle.resume();
+	}
+
+	/// Awaits all the tasks, resumes on the worker that completed the last one.
+	class AllAwaiter
+	{
+	public:
+		AllAwaiter(const TaskHandle* _tasks, uint32_t _count)
+			: m_tasks(_tasks)
+			, m_count(_count)
+			, m_pending(0)
+		{
+		}
+
+		bool await_ready() const noexcept { return m_count == 0; }
+		void await_resume() const noexcept {}
+
+		void await_suspend(std::coroutine_handle<> _handle)
+		{
+			m_handle = _handle;
+
+			// extra count keeps the coroutine suspended until all continuations are attached
+			m_pending.store(m_count + 1, std::memory_order_relaxed);
+			for (uint32_t i=0; i<m_count; ++i)
+			{
+				if (isValid(taskThen(m_tasks[i], onComplete, this, true, "Coroutine resume")))
+					continue;
+
+				// no continuation, wait for the task here and count it off
+				taskWait(m_tasks[i]);
+				onComplete(this, 0, 0);
+			}
+			onComplete(this, 0, 0);
+		}
+
+	private:
+		static void onComplete(void* _userData, uint32_t _start, uint32_t _end)
+		{
+			(void)_start;
+			(void)_end;
+			AllAwaiter* awaiter = (AllAwaiter*)_userData;
+			if (awaiter->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				awaiter->m_handle.resume();
+		}
+
+		const TaskHandle*			m_tasks;
+		uint32_t					m_count;
+		std::atomic<uint32_t>		m_pending;
+		std::coroutine_handle<>		m_handle;
+	};
+
+	/// Awaits a group of tasks, tasks have to be run before awaiting.
+	inline AllAwaiter whenAll(const TaskHandle* _tasks, uint32_t _count)
+	{
+		return AllAwaiter(_tasks, _count);
+	}
+
+	/// Resumes on app thread at the start of the next frame.
+	inline auto nextFrame()
+	{
+		struct Awaiter
+		{
+			bool await_ready() const noexcept { return false; }
+			void await_resume() const noexcept {}
+
+			bool await_suspend(std::coroutine_handle<> _handle)
+			{
+				// invalid parent counts as complete, callback is queued for the next frame right away,
+				// resumes immediately if it couldn't be queued
+				return taskThenOnAppThread({ UINT32_MAX }, detail::resume, _handle.address());
+			}
+		};
+
+		return Awaiter {};
+	}
+
+	/// Resumes on a thread task is pinned to, RAPP_TASK_THREAD_MAIN or RAPP_TASK_THREAD_APP.
+	inline auto resumeOn(uint32_t _thread)
+	{
+		struct Awaiter
+		{
+			uint32_t m_thread;
+
+			bool await_ready() const noexcept { return false; }
+			void await_resume() const noexcept {}
+
+			bool await_suspend(std::coroutine_handle<> _handle)
+			{
+				// resumes on the current thread if the task couldn't be created
+				TaskHandle task = taskCreatePinned(detail::resume, _handle.address(), m_thread, true, "Coroutine resume");
+				if (!isValid(task))
+					return false;
+
+				taskRun(task);
+				return true;
+			}
+		};
+
+		return Awaiter { _thread };
+	}
+
+	/// Resumes on main (message loop) thread.
+	inline auto mainThread()
+	{
+		return resumeOn(RAPP_TASK_THREAD_MAIN);
+	}
+
+	/// Resumes on a worker thread.
+	inline auto worker()
+	{
+		struct Awaiter
+		{
+			bool await_ready() const noexcept { return false; }
+			void await_resume() const noexcept {}
+
+			bool await_suspend(std::coroutine_handle<> _handle)
+			{
+				// resumes on the current thread if the task couldn't be created
+				TaskHandle task = taskCreate(detail::resumeTask, _handle.address(), true, "Coroutine resume");
+				if (!isValid(task))
+					return false;
+
+				taskRun(task);
+				return true;
+			}
+		};
+
+		return Awaiter {};
+	}
+
+} // namespace co
+
+	/// Awaits a task or task group, resumes on the worker that completed it.
+	/// Task has to be run before awaiting.
+	inline auto operator co_await(TaskHandle _task)
+	{
+		struct Awaiter
+		{
+			TaskHandle m_task;
+
+			bool await_ready() const noexcept { return taskStatus(m_task) == RAPP_TASK_STATUS_COMPLETE; }
+			void await_resume() const noexcept {}
+
+			bool await_suspend(std::coroutine_handle<> _handle)
+			{
+				if (isValid(taskThen(m_task, co::detail::resumeTask, _handle.address(), true, "Coroutine resume")))
+					return true;
+
+				// no continuation, wait for the task and resume on the current thread
+				taskWait(m_task);
+				return false;
+			}
+		};
+
+		return Awaiter { _task };
+	}
+
+} // namespace rapp
+
+#endif // RTM_RAPP_CO_H
@@ -5,140 +5,388 @@
 
 #include <task_system_pch.h>
 
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <rapp/inc/rapp_co.h>
+#define TASK_SYSTEM_COROUTINES	1
+#else
+#define TASK_SYSTEM_COROUTINES	0
+#endif
+
+/// Headless task system benchmark, runs once and quits.
+///
+/// Command line options:
+///     --json          : output JSON instead of CSV
+///     --out=<file>    : write results to file instead of stdout
+///     --quick         : fewer iterations, for smoke testing
 struct TaskSystemApp : public rapp::App
 {
 	RAPP_CLASS(TaskSystemApp)
 
-	enum Mode
+	struct Tile
 	{
-		Serial,
-		Parallel
+		uint32_t x, y, w, h, tw, th;
+		uint32_t iterations;	// sum of escape iterations, keeps the kernel from being optimized out
 	};
 
-	Mode	m_runMode;
-
-	struct Tile
+	struct Result
 	{
-		uint32_t x, y, w, h, tw, th;
+		const char*	m_name;
+		uint32_t	m_param;
+		uint32_t	m_iterations;
+		double		m_value;
+		const char*	m_unit;
 	};
 
-	int init(int32_t /*_argc*/, const char* const* /*_argv*/, rtmLibInterface* /*_libInterface = 0*/)
+	static const uint32_t s_width		= 2048;
+	static const uint32_t s_height		= 2048;
+	static const uint32_t s_maxResults	= 64;
+
+	Result		m_results[s_maxResults];
+	uint32_t	m_numResults;
+	bool		m_json;
+	bool		m_quick;
+	const char*	m_outFile;
+
+	int init(int32_t _argc, const char* const* _argv, rtmLibInterface* /*_libInterface = 0*/)
 	{
-		static const rapp::InputBinding bindings[] =
-		{
-			{ 0, "switch", 1, { rapp::KeyboardKey::KeyS, rapp::KeyboardModifier::LCtrl }},
-			{ 0, "exit",   1, { rapp::KeyboardKey::KeyQ, rapp::KeyboardModifier::LCtrl }},
-			RAPP_INPUT_BINDING_END
-		};
+		m_numResults	= 0;
+		m_json			= false;
+		m_quick			= false;
+		m_outFile		= 0;
 
-		rapp::inputAddBindings("bindings", bindings);
-		rapp::cmdAdd("exit",         cmdExit);
-		rapp::cmdAdd("switch", cmdSwitchMode);
+		for (int32_t i=1; i<_argc; ++i)
+		{
+			if (strcmp(_argv[i], "--json") == 0)
+				m_json = true;
+			else
+			if (strcmp(_argv[i], "--quick") == 0)
+				m_quick = true;
+			else
+			if (strncmp(_argv[i], "--out=", 6) == 0)
+				m_outFile = _argv[i] + 6;
+		}
 
-		m_runMode = Mode::Parallel;
 		return 0;
 	}
 
+	bool isGUImode() { return false; }
+
 	void suspend() {}
 	void resume() {}
 
-	static const uint32_t s_width	= 2048;
-	static const uint32_t s_height	= 2048;
-	static const uint32_t s_tile	= 64;
-	static const uint32_t s_tileX	= s_width / s_tile;
-	static const uint32_t s_tileY	= s_height / s_tile;
-
 	void update(float /*_time*/)
 	{
-		static Tile s_tiles[s_tileX * s_tileY];
-		for (uint32_t y=0; y<s_tileY; ++y)
-		for (uint32_t x=0; x<s_tileX; ++x)
+		if (m_numResults)
+			return;
+
+		benchSpawn();
+		benchFanOut();
+		benchSteal();
+		benchWakeLatency();
+		benchCoroutine();
+		benchMandelbrot();
+
+		writeResults();
+		quit();
+	}
+
+	void draw(float /*_alpha*/)
+	{
+	}
+
+	void shutDown()
+	{
+	}
+
+	void addResult(const char* _name, uint32_t _param, uint32_t _iterations, double _value, const char* _unit)
+	{
+		if (m_numResults == s_maxResults)
+			return;
+
+		Result& r		= m_results[m_numResults++];
+		r.m_name		= _name;
+		r.m_param		= _param;
+		r.m_iterations	= _iterations;
+		r.m_value		= _value;
+		r.m_unit		= _unit;
+	}
+
+	static double toUs(uint64_t _ticks)
+	{
+		return (double)_ticks * 1000000.0 / (double)rtm::cpuFrequency();
+	}
+
+	uint32_t iterations(uint32_t _count)
+	{
+		return m_quick ? (_count + 9) / 10 : _count;
+	}
+
+	static void emptyTask(void* /*_userData*/, uint32_t /*_start*/, uint32_t /*_end*/)
+	{
+	}
+
+	/// Time to create, run, wait on and destroy a single empty task.
+	void benchSpawn()
+	{
+		const uint32_t numIterations = iterations(10000);
+
+		uint64_t start = rtm::cpuClock();
+		for (uint32_t i=0; i<numIterations; ++i)
 		{
-			s_tiles[(y*s_tileX) + x].x  = x*s_tile;
-			s_tiles[(y*s_tileX) + x].y  = y*s_tile;
-			s_tiles[(y*s_tileX) + x].w  = s_tile;
-			s_tiles[(y*s_tileX) + x].h  = s_tile;
-			s_tiles[(y*s_tileX) + x].tw = s_width;
-			s_tiles[(y*s_tileX) + x].th = s_height;
+			rapp::TaskHandle task = rapp::taskCreate(emptyTask, 0, false);
+			rapp::taskRun(task);
+			rapp::taskWait(task);
+			rapp::taskDestroy(task);
 		}
+		uint64_t end = rtm::cpuClock();
+
+		addResult("spawn_complete", 1, numIterations, toUs(end - start) / numIterations, "us");
+	}
 
-		float startTime = rtm::cpuTime();
+	/// Fan-out/fan-in of a group of empty tasks, one partition per item.
+	void benchFanOut()
+	{
+		static const uint32_t partitions[] = { 1, 10, 100, 1000, 10000, 100000 };
 
-		switch (m_runMode)
+		for (uint32_t p=0; p<RTM_NUM_ELEMENTS(partitions); ++p)
 		{
-			case Serial:
-				{
-					tileMandelbrot(s_tiles, 0, s_tileX * s_tileY);
-				};
-				break;
+			const uint32_t numIterations = iterations(partitions[p] >= 10000 ? 100 : 1000);
 
-			case Parallel:
-				{
-					rapp::TaskHandle group = rapp::taskCreateGroup(tileMandelbrot, s_tiles, sizeof(Tile), s_tileX * s_tileY, false);
-					rapp::taskRun(group);
-					rapp::taskWait(group);
-					rapp::taskDestroy(group);
-				};
-				break;
-		};
+			uint64_t start = rtm::cpuClock();
+			for (uint32_t i=0; i<numIterations; ++i)
+			{
+				rapp::TaskHandle group = rapp::taskCreateGroup(emptyTask, 0, 0, partitions[p], false);
+				rapp::taskRun(group);
+				rapp::taskWait(group);
+				rapp::taskDestroy(group);
+			}
+			uint64_t end = rtm::cpuClock();
 
-		float endTime = rtm::cpuTime();
+			addResult("fan_out_in", partitions[p], numIterations, toUs(end - start) / numIterations, "us");
+		}
+	}
 
-		rtm::Console::rgb(	0, 255, 0,
-								"%s Mandelbrot set (%d x %d) took: %f ms in %d tiles   - (Ctrl+S to switch execution mode)\n",
-								m_runMode == Mode::Serial ? "Serial" : "Parallel",
-								s_width, s_height, (endTime-startTime)*1000.0f,
-								s_tileX*s_tileY);
+	static void spin(uint64_t _ticks)
+	{
+		uint64_t end = rtm::cpuClock() + _ticks;
+		while (rtm::cpuClock() < end);
 	}
 
-	void draw(float /*_alpha*/)
+	/// First eighth of items is 64 times as expensive, workers have to steal to balance the load.
+	static void imbalancedTask(void* _userData, uint32_t _start, uint32_t _end)
 	{
+		uint32_t count = *(uint32_t*)_userData;
+		uint64_t ticks = rtm::cpuFrequency() / 1000000;	// ~1us
+		for (uint32_t i=_start; i<_end; ++i)
+			spin(i < count / 8 ? ticks * 64 : ticks);
 	}
 
-	void shutDown()
+	void benchSteal()
+	{
+		const uint32_t numIterations	= iterations(20);
+		uint32_t count					= 16 * 1024;
+
+		static rapp::TaskStats statsBefore;
+		static rapp::TaskStats statsAfter;
+		rapp::taskGetStats(statsBefore);
+
+		uint64_t start = rtm::cpuClock();
+		for (uint32_t i=0; i<numIterations; ++i)
+		{
+			rapp::TaskHandle group = rapp::taskCreateGroup(imbalancedTask, &count, 0, count, false);
+			rapp::taskRun(group);
+			rapp::taskWait(group);
+			rapp::taskDestroy(group);
+		}
+		uint64_t end = rtm::cpuClock();
+
+		rapp::taskGetStats(statsAfter);
+
+		uint64_t remote = 0;
+		for (uint32_t i=0; i<statsAfter.m_numThreads; ++i)
+			remote += statsAfter.m_threads[i].m_numRemote - statsBefore.m_threads[i].m_numRemote;
+
+		double seconds = toUs(end - start) / 1000000.0;
+		addResult("steal_throughput",	count, numIterations, (double)count * numIterations / seconds, "items/s");
+		addResult("remote_partitions",	count, numIterations, (double)remote / numIterations, "partitions");
+	}
+
+	/// Task records its finish time after sleeping long enough for the waiter to suspend.
+	static void sleepTask(void* _userData, uint32_t /*_start*/, uint32_t /*_end*/)
+	{
+		rtm::threadSleep(1);
+		*(volatile uint64_t*)_userData = rtm::cpuClock();
+	}
+
+	void benchWakeLatency()
+	{
+		const uint32_t numIterations = iterations(200);
+
+		uint64_t total	= 0;
+		uint64_t worst	= 0;
+		for (uint32_t i=0; i<numIterations; ++i)
+		{
+			volatile uint64_t finish = 0;
+			rapp::TaskHandle task = rapp::taskCreate(sleepTask, (void*)&finish, false);
+			rapp::taskRun(task);
+			rapp::taskWait(task);
+			uint64_t latency = rtm::cpuClock() - finish;
+			rapp::taskDestroy(task);
+
+			total += latency;
+			worst = latency > worst ? latency : worst;
+		}
+
+		addResult("wait_wake_latency",		1, numIterations, toUs(total) / numIterations, "us");
+		addResult("wait_wake_latency_max",	1, numIterations, toUs(worst), "us");
+	}
+
+#if TASK_SYSTEM_COROUTINES
+	static rapp::co::Task<void> awaitTask(rapp::TaskHandle _task)
+	{
+		co_await _task;
+	}
+
+	/// Time to resume a coroutine awaiting a running task, only built with C++20.
+	void benchCoroutine()
+	{
+		const uint32_t numIterations = iterations(1000);
+
+		uint64_t start = rtm::cpuClock();
+		for (uint32_t i=0; i<numIterations; ++i)
+		{
+			rapp::TaskHandle task = rapp::taskCreate(emptyTask, 0, false);
+			rapp::taskRun(task);
+
+			rapp::co::Task<void> co = awaitTask(task);
+			co.start();
+			while (!co.isDone());
+
+			rapp::taskWait(task);
+			rapp::taskDestroy(task);
+		}
+		uint64_t end = rtm::cpuClock();
+
+		addResult("coroutine_await", 1, numIterations, toUs(end - start) / numIterations, "us");
+	}
+#else
+	void benchCoroutine()
+	{
+	}
+#endif
+
+	void benchMandelbrot()
+	{
+		static const uint32_t tileSizes[] = { 16, 32, 64, 128, 256 };
+		static Tile s_tiles[(s_width / 16) * (s_height / 16)];
+
+		const uint32_t numIterations = iterations(10);
+
+		for (uint32_t t=0; t<RTM_NUM_ELEMENTS(tileSizes); ++t)
+		{
+			const uint32_t tile		= tileSizes[t];
+			const uint32_t tileX	= s_width / tile;
+			const uint32_t tileY	= s_height / tile;
+			const uint32_t numTiles	= tileX * tileY;
+
+			for (uint32_t y=0; y<tileY; ++y)
+			for (uint32_t x=0; x<tileX; ++x)
+			{
+				s_tiles[(y*tileX) + x].x  = x*tile;
+				s_tiles[(y*tileX) + x].y  = y*tile;
+				s_tiles[(y*tileX) + x].w  = tile;
+				s_tiles[(y*tileX) + x].h  = tile;
+				s_tiles[(y*tileX) + x].tw = s_width;
+				s_tiles[(y*tileX) + x].th = s_height;
+			}
+
+			uint64_t start = rtm::cpuClock();
+			for (uint32_t i=0; i<numIterations; ++i)
+				tileMandelbrot(s_tiles, 0, numTiles);
+			uint64_t serial = rtm::cpuClock() - start;
+
+			start = rtm::cpuClock();
+			for (uint32_t i=0; i<numIterations; ++i)
+			{
+				rapp::TaskHandle group = rapp::taskCreateParallelFor(tileMandelbrot, s_tiles, sizeof(Tile), numTiles, 0, false, "Mandelbrot tiles");
+				rapp::taskRun(group);
+				rapp::taskWait(group);
+				rapp::taskDestroy(group);
+			}
+			uint64_t parallel = rtm::cpuClock() - start;
+
+			addResult("mandelbrot_serial",		tile, numIterations, toUs(serial)	/ numIterations / 1000.0, "ms");
+			addResult("mandelbrot_parallel",	tile, numIterations, toUs(parallel)	/ numIterations / 1000.0, "ms");
+		}
+	}
+
+	void writeResults()
 	{
-		rtm::Console::rgb(255, 255, 0, "Shutting down app\n");
-		rapp::inputRemoveBindings("bindings");
+		FILE* file = m_outFile ? fopen(m_outFile, "w") : stdout;
+		if (!file)
+		{
+			rtm::Console::rgb(255, 0, 0, "Failed to open %s for writing\n", m_outFile);
+			return;
+		}
+
+		if (m_json)
+		{
+			fprintf(file, "[\n");
+			for (uint32_t i=0; i<m_numResults; ++i)
+			{
+				const Result& r = m_results[i];
+				fprintf(file, "\t{ \"benchmark\": \"%s\", \"param\": %u, \"iterations\": %u, \"value\": %f, \"unit\": \"%s\" }%s\n",
+					r.m_name, r.m_param, r.m_iterations, r.m_value, r.m_unit, i + 1 < m_numResults ? "," : "");
+			}
+			fprintf(file, "]\n");
+		}
+		else
+		{
+			fprintf(file, "benchmark,param,iterations,value,unit\n");
+			for (uint32_t i=0; i<m_numResults; ++i)
+			{
+				const Result& r = m_results[i];
+				fprintf(file, "%s,%u,%u,%f,%s\n", r.m_name, r.m_param, r.m_iterations, r.m_value, r.m_unit);
+			}
+		}
+
+		if (file != stdout)
+			fclose(file);
 	}
 
+	// _userData points to the first tile of the range
 	static void tileMandelbrot(void* _userData, uint32_t _start, uint32_t _end)
 	{
-		for (uint32_t range=_start; range<_end; ++range)
+		for (uint32_t range=0; range<_end-_start; ++range)
 		{
 			Tile* tile = &((Tile*)_userData)[range];
+			uint32_t sum = 0;
 
 			for (uint32_t Y = tile->y; Y < tile->y + tile->h; ++Y)
 			for (uint32_t X = tile->x; X < tile->x + tile->w; ++X)
 			{
-				float x = (float)Y * 2 / tile->tw - 1.5f;
-				float y = (float)X * 2 / tile->th - 1;
+				const float cx = (float)X * 3 / tile->tw - 2.0f;
+				const float cy = (float)Y * 2 / tile->th - 1.0f;
+				float x = 0.0f;
+				float y = 0.0f;
 
-				int iteration = 0;
-				while (++iteration < 12)
+				uint32_t iteration = 0;
+				while ((++iteration < 12) && (x * x + y * y < 4.0f))
 				{
-					const float nx = x * x - y * y;
-					const float ny = 2.0f * x * y;
+					const float nx = x * x - y * y + cx;
+					const float ny = 2.0f * x * y + cy;
 					x = nx;
 					y = ny;
 				}
+				sum += iteration;
 			}
-		}
-	}
 
-	static int cmdExit(App* _app, void* _userData, int _argc, char const* const* _argv)
-	{
-		RTM_UNUSED_3(_userData, _argv, _argc);
-		_app->quit();
-		return 0;
-	}
-
-	static int cmdSwitchMode(App* _app, void* _userData, int _argc, char const* const* _argv)
-	{
-		RTM_UNUSED_3(_userData, _argv, _argc);
-		TaskSystemApp* app = (TaskSystemApp*)_app;
-		app->m_runMode = (app->m_runMode == Mode::Parallel) ? Mode::Serial : Mode::Parallel;
-		return 0;
+			tile->iterations = sum;
+		}
 	}
 };
 
-RAPP_REGISTER(TaskSystemApp, "Task scheduling system", "Example of using the task system");
+RAPP_REGISTER(TaskSystemApp, "Task scheduling system", "Task system benchmark, outputs CSV or JSON");
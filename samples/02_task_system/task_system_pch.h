@@ -8,5 +8,6 @@
 #include <rbase/inc/console.h>
 #include <rbase/inc/cpu.h>
 #include <rbase/inc/libassert.h>
+#include <rbase/inc/thread.h>
 
 #include <rapp/inc/rapp.h>
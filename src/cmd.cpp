@@ -479,4 +479,157 @@ int cmdApp(App* _app, void* _userData, int _argc, char const* const* _argv)
 	return 1;
 }
 
+int cmdTasks(App* _app, void* _userData, int _argc, char const* const* _argv)
+{
+	RTM_UNUSED_2(_app, _userData);
+
+	if (_argc > 1)
+	{
+		if (rtm::striCmp(_argv[1], "help") == 0)
+		{
+			cmdConsoleLog(_app, "tasks stats         - per thread task scheduler statistics");
+			cmdConsoleLog(_app, "tasks config        - task system configuration, set with --task-* command line options");
+			cmdConsoleLog(_app, "tasks serial on|off - run task sets inline in submission order");
+			cmdConsoleLog(_app, "tasks timings       - per task serial and parallel timings");
+			cmdConsoleLog(_app, "tasks timings on|off|reset - controls recording of per task timings");
+			return 0;
+		}
+
+		if (rtm::striCmp(_argv[1], "config") == 0)
+		{
+			TaskConfig config;
+			taskGetConfig(config);
+
+			cmdConsoleLog(_app, "Workers:        %u (0 = default)", config.m_numWorkers);
+			cmdConsoleLog(_app, "Reserved cores: %u", config.m_numReservedCores);
+			cmdConsoleLog(_app, "Affinity mask:  0x%" PRIx64, config.m_affinityMask);
+			cmdConsoleLog(_app, "Wait policy:    %s", config.m_waitPolicy == RAPP_TASK_WAIT_SPIN ? "spin" : "sleep");
+			cmdConsoleLog(_app, "I/O threads:    %u", config.m_numIoThreads);
+			cmdConsoleLog(_app, "Serial:         %s", config.m_serial ? "on" : "off");
+			cmdConsoleLog(_app, "Timings:        %s", config.m_recordTimings ? "on" : "off");
+			return 0;
+		}
+
+		if (rtm::striCmp(_argv[1], "serial") == 0)
+		{
+			if (_argc < 3)
+				return 1;
+
+			taskSetSerial(rtm::striCmp(_argv[2], "on") == 0);
+			return 0;
+		}
+
+		if (rtm::striCmp(_argv[1], "timings") == 0)
+		{
+			if (_argc > 2)
+			{
+				if (rtm::striCmp(_argv[2], "reset") == 0)
+					taskResetTimings();
+				else
+					taskSetRecordTimings(rtm::striCmp(_argv[2], "on") == 0);
+				return 0;
+			}
+
+			static TaskTiming timings[RAPP_TASK_TIMING_TABLE_SIZE];
+			uint32_t numTimings = taskGetTimings(timings, RAPP_TASK_TIMING_TABLE_SIZE);
+
+			cmdConsoleLogRGB(127, 255, 255, _app, "Task                       Serial  Avg ms  Parallel  Avg ms  Ratio");
+			for (uint32_t i=0; i<numTimings; ++i)
+			{
+				const TaskTiming& t = timings[i];
+				float avgSerial		= t.m_numSerial ? t.m_timeSerial / (float)t.m_numSerial : 0.0f;
+				float avgParallel	= t.m_numParallel ? t.m_timeParallel / (float)t.m_numParallel : 0.0f;
+				cmdConsoleLog(_app, "%-24.24s %8" PRIu64 " %7.3f %9" PRIu64 " %7.3f %6.2f",	t.m_name,
+																							t.m_numSerial,
+																							avgSerial,
+																							t.m_numParallel,
+																							avgParallel,
+																							avgSerial > 0.0f ? avgParallel / avgSerial : 0.0f);
+			}
+			return 0;
+		}
+
+		if (rtm::striCmp(_argv[1], "stats") == 0)
+		{
+			static TaskStats stats;
+			taskGetStats(stats);
+
+			cmdConsoleLogRGB(127, 255, 255, _app, "Tasks submitted: %" PRIu64 ", pipe full: %" PRIu64, stats.m_numSubmitted, stats.m_numPipeFull);
+			cmdConsoleLogRGB(127, 255, 255, _app, "Thread   Executed     Remote    Busy ms    Wait ms  Suspend ms");
+			for (uint32_t i=0; i<stats.m_numThreads; ++i)
+			{
+				const TaskThreadStats& ts = stats.m_threads[i];
+				cmdConsoleLog(_app, "%6u %10" PRIu64 " %10" PRIu64 " %10.2f %10.2f %11.2f",	i,
+																						ts.m_numExecuted,
+																						ts.m_numRemote,
+																						ts.m_timeBusy,
+																						ts.m_timeWaiting,
+																						ts.m_timeSuspended);
+			}
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+int cmdEvents(App* _app, void* _userData, int _argc, char const* const* _argv)
+{
+	RTM_UNUSED(_userData);
+
+	static const char* s_policyName[EventOverflow::Count] = { "block", "dropnewest", "coalesce" };
+
+	EventQueue* queue = eventQueueGet();
+
+	if (_argc > 1)
+	{
+		if (rtm::striCmp(_argv[1], "help") == 0)
+		{
+			cmdConsoleLog(_app, "events stats        - event queue usage, dropped and coalesced events");
+			cmdConsoleLog(_app, "events reset        - resets event queue statistics");
+			cmdConsoleLog(_app, "events policy block|dropnewest|coalesce - handling of mouse moves and axis values posted to a full queue");
+			return 0;
+		}
+
+		if (rtm::striCmp(_argv[1], "stats") == 0)
+		{
+			EventQueueStats stats;
+			queue->getStats(stats);
+
+			cmdConsoleLog(_app, "Policy:     %s", s_policyName[stats.m_policy]);
+			cmdConsoleLog(_app, "Producers:  %u", stats.m_numProducers);
+			cmdConsoleLog(_app, "Capacity:   %u per producer", stats.m_capacity);
+			cmdConsoleLog(_app, "Queued:     %u", stats.m_size);
+			cmdConsoleLog(_app, "High water: %u", stats.m_highWater);
+			cmdConsoleLog(_app, "Blocked:    %u", stats.m_numBlocked);
+			cmdConsoleLog(_app, "Dropped:    %u", stats.m_numDropped);
+			cmdConsoleLog(_app, "Coalesced:  %u", stats.m_numCoalesced);
+			return 0;
+		}
+
+		if (rtm::striCmp(_argv[1], "reset") == 0)
+		{
+			queue->resetStats();
+			return 0;
+		}
+
+		if (rtm::striCmp(_argv[1], "policy") == 0)
+		{
+			if (_argc < 3)
+				return 1;
+
+			for (uint32_t i=0; i<EventOverflow::Count; ++i)
+			{
+				if (rtm::striCmp(_argv[2], s_policyName[i]) == 0)
+				{
+					queue->setPolicy((EventOverflow::Enum)i);
+					return 0;
+				}
+			}
+		}
+	}
+
+	return 1;
+}
+
 } // namespace rapp
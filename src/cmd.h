@@ -47,6 +47,8 @@ namespace rapp {
 	int cmdMouseLock(App* _app, void* _userData, int _argc, char const* const* _argv);
 	int cmdGraphics(App* _app, void* _userData, int _argc, char const* const* _argv);
 	int cmdApp(App* _app, void* _userData, int _argc, char const* const* _argv);
+	int cmdTasks(App* _app, void* _userData, int _argc, char const* const* _argv);
+	int cmdEvents(App* _app, void* _userData, int _argc, char const* const* _argv);
 
 } // namespace rtm
 
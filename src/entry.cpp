@@ -11,6 +11,19 @@
 #include <rapp/src/cmd.h>
 #include <rapp/src/input.h>
 
+#include <rbase/inc/thread.h>
+
+#include <mutex>
+
+#if RTM_PLATFORM_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif RTM_PLATFORM_WINDOWS
+#include <windows.h>
+#pragma comment(lib, "Synchronization.lib")	// WaitOnAddress
+#endif // RTM_PLATFORM_LINUX
+
 namespace rapp
 {
 	int rapp_main(int _argc, const char* const*);
@@ -70,6 +83,158 @@ namespace rapp
 	ImGuiKey	s_keyMap[KeyboardKey::Count];
 #endif // RAPP_WITH_BGFX
 
+	void eventQueueWait(std::atomic<uint32_t>* _address, uint32_t _value)
+	{
+#if RTM_PLATFORM_LINUX
+		syscall(SYS_futex, (uint32_t*)_address, FUTEX_WAIT_PRIVATE, _value, NULL, NULL, 0);
+#elif RTM_PLATFORM_WINDOWS
+		WaitOnAddress((volatile VOID*)_address, &_value, sizeof(uint32_t), INFINITE);
+#else
+		RTM_UNUSED_2(_address, _value);
+		rtm::threadSleep(1);
+#endif // RTM_PLATFORM_LINUX
+	}
+
+	void eventQueueWake(std::atomic<uint32_t>* _address)
+	{
+#if RTM_PLATFORM_LINUX
+		syscall(SYS_futex, (uint32_t*)_address, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#elif RTM_PLATFORM_WINDOWS
+		WakeByAddressSingle((PVOID)_address);
+#else
+		RTM_UNUSED(_address);
+#endif // RTM_PLATFORM_LINUX
+	}
+
+	static std::mutex	s_eventQueueLock;
+	static EventQueue*	s_eventQueues[RAPP_EVENT_MAX_QUEUES];
+	static uint32_t		s_eventQueueIds[RAPP_EVENT_MAX_QUEUES];
+	static uint32_t		s_eventQueueNextId = 0;
+
+	/// Called with lock held.
+	static bool eventQueueIsLive(EventQueue* _queue, uint32_t _id)
+	{
+		for (uint32_t i=0; i<RAPP_EVENT_MAX_QUEUES; ++i)
+		{
+			if (s_eventQueues[i] == _queue && s_eventQueueIds[i] == _id)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	uint32_t eventQueueRegister(EventQueue* _queue)
+	{
+		std::unique_lock<std::mutex> lock(s_eventQueueLock);
+
+		const uint32_t id = ++s_eventQueueNextId;
+		for (uint32_t i=0; i<RAPP_EVENT_MAX_QUEUES; ++i)
+		{
+			if (NULL == s_eventQueues[i])
+			{
+				s_eventQueues[i]	= _queue;
+				s_eventQueueIds[i]	= id;
+				return id;
+			}
+		}
+
+		RTM_ERROR("Too many event queues, increase RAPP_EVENT_MAX_QUEUES!");
+		return id;
+	}
+
+	void eventQueueUnregister(EventQueue* _queue)
+	{
+		std::unique_lock<std::mutex> lock(s_eventQueueLock);
+
+		for (uint32_t i=0; i<RAPP_EVENT_MAX_QUEUES; ++i)
+		{
+			if (s_eventQueues[i] == _queue)
+			{
+				s_eventQueues[i] = NULL;
+			}
+		}
+	}
+
+	/// Lanes held by a posting thread, released back to queues that still exist when the thread exits.
+	struct EventProducer
+	{
+		struct Entry
+		{
+			EventQueue*	m_queue;
+			uint32_t	m_id;
+			uint32_t	m_lane;		// UINT32_MAX if queue had no free lane
+		};
+
+		Entry		m_entries[RAPP_EVENT_MAX_QUEUES];
+		uint32_t	m_numEntries;
+
+		EventProducer()
+			: m_numEntries(0)
+		{
+		}
+
+		~EventProducer()
+		{
+			std::unique_lock<std::mutex> lock(s_eventQueueLock);
+
+			for (uint32_t i=0; i<m_numEntries; ++i)
+			{
+				const Entry& entry = m_entries[i];
+				if (entry.m_lane != UINT32_MAX && eventQueueIsLive(entry.m_queue, entry.m_id) )
+				{
+					entry.m_queue->releaseLane(entry.m_lane);
+				}
+			}
+		}
+	};
+
+	static thread_local EventProducer s_eventProducer;
+
+	uint32_t eventQueueProducerLane(EventQueue* _queue, uint32_t _id, bool _claim)
+	{
+		EventProducer& producer = s_eventProducer;
+
+		for (uint32_t i=0; i<producer.m_numEntries; ++i)
+		{
+			const EventProducer::Entry& entry = producer.m_entries[i];
+			if (entry.m_queue == _queue && entry.m_id == _id)
+			{
+				return entry.m_lane;
+			}
+		}
+
+		if (!_claim)
+		{
+			return UINT32_MAX;
+		}
+
+		std::unique_lock<std::mutex> lock(s_eventQueueLock);
+
+		// forget queues destroyed since, their lanes are gone with them
+		uint32_t numEntries = 0;
+		for (uint32_t i=0; i<producer.m_numEntries; ++i)
+		{
+			if (eventQueueIsLive(producer.m_entries[i].m_queue, producer.m_entries[i].m_id) )
+			{
+				producer.m_entries[numEntries++] = producer.m_entries[i];
+			}
+		}
+		producer.m_numEntries = numEntries;
+
+		const uint32_t lane = _queue->claimLane();
+		if (producer.m_numEntries < RAPP_EVENT_MAX_QUEUES)
+		{
+			EventProducer::Entry& entry = producer.m_entries[producer.m_numEntries++];
+			entry.m_queue	= _queue;
+			entry.m_id		= _id;
+			entry.m_lane	= lane;
+		}
+
+		return lane;
+	}
+
 	const char* getName(KeyboardKey::Enum _key)
 	{
 		RTM_ASSERT(_key < KeyboardKey::Count, "Invalid key %d.", _key);
@@ -101,6 +266,7 @@ namespace rapp
 	{
 		cmdInit();
 		cmdAdd("mouselock", cmdMouseLock, 0, "locks mouse to window");
+		cmdAdd("events",    cmdEvents,    0, "Event queue commands, type 'events help' for more info");
 #ifdef RAPP_WITH_BGFX
 		cmdAdd("graphics",  cmdGraphics,  0, "Graphics related commands, type 'graphics help' for list of options");
 		rapp::inputAddBindings("graphics", s_bindingsGraphics);
@@ -468,6 +468,11 @@ namespace rapp
 		s_ctx.m_eventQueue.release(_event);
 	}
 
+	EventQueue* eventQueueGet()
+	{
+		return &s_ctx.m_eventQueue;
+	}
+
 	void appRunOnMainThread(ThreadFn _fn, void* _userData)
 	{
 		RAPP_CMD_WRITE(Command::RunFunc);
@@ -531,6 +531,11 @@ namespace rapp
 		s_ctx.m_eventQueue.release(_event);
 	}
 
+	EventQueue* eventQueueGet()
+	{
+		return &s_ctx.m_eventQueue;
+	}
+
 	void appRunOnMainThread(ThreadFn _fn, void* _userData)
 	{
 		_fn(_userData);
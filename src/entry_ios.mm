@@ -97,6 +97,11 @@ namespace rapp
 		s_ctx->m_eventQueue.release(_event);
 	}
 
+	EventQueue* eventQueueGet()
+	{
+		return &s_ctx->m_eventQueue;
+	}
+
 	void appRunOnMainThread(App::threadFn _fn, void* _userData)
 	{
 	}
@@ -8,7 +8,11 @@
 
 #include <rapp/inc/rapp.h>
 #include <rapp/src/input.h>
+#include <rapp/src/rapp_config.h>
 #include <string.h> // memcpy
+#include <atomic>
+#include <new>
+#include <type_traits>
 
 #ifndef ENTRY_CONFIG_MAX_GAMEPADS
 #	define ENTRY_CONFIG_MAX_GAMEPADS 4
@@ -103,6 +107,9 @@ namespace rapp
 		int32_t				m_mx;
 		int32_t				m_my;
 		int32_t				m_mz;
+		int32_t				m_dx;		// movement since previous mouse event, sum of coalesced moves
+		int32_t				m_dy;
+		int32_t				m_dz;
 		MouseButton::Enum	m_button;
 		bool				m_down;
 		bool				m_doubleClick;
@@ -145,14 +152,97 @@ namespace rapp
 	const Event* poll(WindowHandle _handle);
 	void release(const Event* _event);
 
-	class EventQueue
+	class EventQueue;
+
+	/// Returns event queue of the platform entry.
+	EventQueue* eventQueueGet();
+
+	/// Fixed size record large enough to hold any event, events are constructed in place.
+	struct EventRecord
+	{
+		template <typename T0, typename... T>
+		struct MaxSize { static const size_t value = sizeof(T0) > MaxSize<T...>::value ? sizeof(T0) : MaxSize<T...>::value; };
+
+		template <typename T0>
+		struct MaxSize<T0> { static const size_t value = sizeof(T0); };
+
+		static const size_t kSize = MaxSize<Event, AxisEvent, CharEvent, GamepadEvent, GamepadButtonsEvent
+										  , KeyEvent, MouseEvent, SizeEvent, WindowEvent, SuspendEvent>::value;
+
+		alignas(void*) uint8_t	m_data[kSize];		// first, event pointer is also record pointer
+		uint32_t				m_sequence;			// write order across producers, taken when the record is claimed
+	};
+
+	/// Policy for droppable events (mouse moves and gamepad axis values) posted to a full queue,
+	/// other events always wait for the consumer.
+	struct EventOverflow
+	{
+		enum Enum
+		{
+			Block,		// wait for consumer to release a record
+			DropNewest,	// discard the event being posted, consumer gets the older moves already queued
+			Coalesce,	// keep latest mouse move and axis values aside, posted once there is room
+
+			Count
+		};
+	};
+
+	struct EventQueueStats
+	{
+		EventOverflow::Enum	m_policy;
+		uint32_t			m_capacity;
+		uint32_t			m_size;
+		uint32_t			m_highWater;
+		uint32_t			m_numBlocked;		// times producer had to wait for consumer
+		uint32_t			m_numDropped;
+		uint32_t			m_numCoalesced;		// merged while draining or while queue was full
+		uint32_t			m_numProducers;
+	};
+
+	/// Producer blocks on futex (WaitOnAddress on Windows) while queue is full, consumer wakes it after
+	/// releasing a record. Other platforms sleep for 1 ms and check again.
+	void eventQueueWait(std::atomic<uint32_t>* _address, uint32_t _value);
+	void eventQueueWake(std::atomic<uint32_t>* _address);
+
+	/// Live queues are registered so lanes of exiting threads are only released back to queues that still exist.
+	uint32_t eventQueueRegister(EventQueue* _queue);
+	void eventQueueUnregister(EventQueue* _queue);
+
+	/// Returns lane calling thread holds in a queue, claims one if it has none and _claim is set.
+	/// Lanes are released when the thread exits. Returns UINT32_MAX if there is no lane.
+	uint32_t eventQueueProducerLane(EventQueue* _queue, uint32_t _id, bool _claim);
+
+	RTM_STATIC_ASSERT(ENTRY_CONFIG_MAX_GAMEPADS * GamepadAxis::Count <= 32);	// staged axis values are tracked in 32 bit mask
+	RTM_STATIC_ASSERT(0 == (RAPP_EVENT_QUEUE_SIZE & RAPP_EVENT_QUEUE_MASK) );
+
+	/// Single producer, single consumer ring of event records.
+	/// Posting writes the record in place, poll returns the oldest record without consuming it and
+	/// release frees its slot, so there is at most one event in flight on the consumer side.
+	/// Poll coalesces consecutive mouse moves for the same window and drops axis values superseded
+	/// by a newer value of the same gamepad axis, button and key edges are always delivered in order.
+	class EventLane
 	{
 	public:
-		EventQueue()
-			: m_queue(2048)
-		{}
+		EventLane()
+			: m_sequence(NULL)
+			, m_overflow(false)
+			, m_stagedMouse(false)
+			, m_stagedAxisMask(0)
+			, m_policy(EventOverflow::Block)
+			, m_highWater(0)
+			, m_numBlocked(0)
+			, m_numDropped(0)
+			, m_numCoalesced(0)
+			, m_waiting(0)
+			, m_write(0)
+			, m_read(0)
+		{
+			m_mouse[0] = 0;
+			m_mouse[1] = 0;
+			m_mouse[2] = 0;
+		}
 
-		~EventQueue()
+		~EventLane()
 		{
 			for (const Event* ev = poll(); NULL != ev; ev = poll() )
 			{
@@ -162,134 +252,768 @@ namespace rapp
 
 		void postAxisEvent(WindowHandle _handle, GamepadHandle _gamepad, GamepadAxis::Enum _axis, int32_t _value)
 		{
-			AxisEvent* ev = new AxisEvent(_handle);
+			AxisEvent* ev = alloc<AxisEvent>(_handle, true);
 			ev->m_gamepad = _gamepad;
 			ev->m_axis    = _axis;
 			ev->m_value   = _value;
-			while(!m_queue.write(ev));
+			commit();
 		}
 
 		void postCharEvent(WindowHandle _handle, uint8_t _len, const uint8_t _char[4])
 		{
-			CharEvent* ev = new CharEvent(_handle);
+			CharEvent* ev = alloc<CharEvent>(_handle);
 			ev->m_len = _len;
 			memcpy(ev->m_char, _char, 4);
-			while(!m_queue.write(ev));
+			commit();
 		}
 
 		void postExitEvent()
 		{
-			Event* ev = new Event(Event::Exit);
-			while(!m_queue.write(ev));
+			new (slot(false) ) Event(Event::Exit);
+			commit();
 		}
 
 		void postGamepadEvent(WindowHandle _handle, GamepadHandle _gamepad, bool _connected)
 		{
-			GamepadEvent* ev = new GamepadEvent(_handle);
+			GamepadEvent* ev = alloc<GamepadEvent>(_handle);
 			ev->m_gamepad   = _gamepad;
 			ev->m_connected = _connected;
-			while(!m_queue.write(ev));
+			commit();
 		}
 
 		void postGamepadButtonsEvent(WindowHandle _handle, GamepadHandle _gamepad, GamepadButton::Enum _button, bool _pressed)
 		{
-			GamepadButtonsEvent* ev = new GamepadButtonsEvent(_handle);
+			GamepadButtonsEvent* ev = alloc<GamepadButtonsEvent>(_handle);
 			ev->m_gamepad	= _gamepad;
 			ev->m_button	= _button;
 			ev->m_pressed	= _pressed;
-			while(!m_queue.write(ev));
+			commit();
 		}
 
 		void postKeyEvent(WindowHandle _handle, KeyboardKey::Enum _key, uint8_t _modifiers, bool _down)
 		{
-			KeyEvent* ev = new KeyEvent(_handle);
+			KeyEvent* ev = alloc<KeyEvent>(_handle);
 			ev->m_key       = _key;
 			ev->m_modifiers = _modifiers;
 			ev->m_down      = _down;
-			ev->m_modifiers = _modifiers;
-			while(!m_queue.write(ev));
+			commit();
 		}
 
 		void postMouseEvent(WindowHandle _handle, int32_t _mx, int32_t _my, int32_t _mz, uint8_t _modifiers)
 		{
-			MouseEvent* ev = new MouseEvent(_handle);
+			MouseEvent* ev = alloc<MouseEvent>(_handle, true);
 			ev->m_mx          = _mx;
 			ev->m_my          = _my;
 			ev->m_mz          = _mz;
+			setMouseDelta(ev);
 			ev->m_button      = MouseButton::None;
 			ev->m_down        = false;
 			ev->m_move        = true;
 			ev->m_modifiers   = _modifiers;
 			ev->m_doubleClick = false;
-			while(!m_queue.write(ev));
+			commit();
 		}
 
 		void postMouseEvent(WindowHandle _handle, int32_t _mx, int32_t _my, int32_t _mz, MouseButton::Enum _button, uint8_t _modifiers, bool _down, bool _double)
 		{
-			MouseEvent* ev = new MouseEvent(_handle);
+			MouseEvent* ev = alloc<MouseEvent>(_handle);
 			ev->m_mx          = _mx;
 			ev->m_my          = _my;
 			ev->m_mz          = _mz;
+			setMouseDelta(ev);
 			ev->m_button      = _button;
 			ev->m_down        = _down;
 			ev->m_move        = false;
 			ev->m_modifiers   = _modifiers;
 			ev->m_doubleClick = _double;
-			while(!m_queue.write(ev));
+			commit();
 		}
 
 		void postSizeEvent(WindowHandle _handle, uint32_t _width, uint32_t _height)
 		{
-			SizeEvent* ev = new SizeEvent(_handle);
+			SizeEvent* ev = alloc<SizeEvent>(_handle);
 			ev->m_width  = static_cast<uint16_t>(_width);
 			ev->m_height = static_cast<uint16_t>(_height);
-			while(!m_queue.write(ev));
+			commit();
 		}
 
 		void postWindowEvent(WindowHandle _handle, void* _nwh = NULL)
 		{
-			WindowEvent* ev = new WindowEvent(_handle);
+			WindowEvent* ev = alloc<WindowEvent>(_handle);
 			ev->m_nwh = _nwh;
-			while(!m_queue.write(ev));
+			commit();
 		}
 
 		void postSuspendEvent(WindowHandle _handle, SuspendEvent::Enum _suspendState)
 		{
-			SuspendEvent* ev = new SuspendEvent(_handle);
+			SuspendEvent* ev = alloc<SuspendEvent>(_handle);
 			ev->m_eventState = _suspendState;
-			while(!m_queue.write(ev));
+			commit();
 		}
 
 		const Event* poll()
 		{
-			Event* e = 0;
-			m_queue.read(&e);
-			return (Event*)e;
+			uint32_t read = m_read.load(std::memory_order_relaxed);
+			const uint32_t write = m_write.load(std::memory_order_acquire);
+			if (read == write)
+			{
+				return NULL;
+			}
+
+			Event* ev = record(read);
+			while (superseded(ev, read, write) )
+			{
+				ev = record(++read);
+			}
+
+			if (read != m_read.load(std::memory_order_relaxed) )
+			{
+				advance(read);
+			}
+
+			return ev;
 		}
 
 		const Event* poll(WindowHandle _handle)
 		{
-			if (isValid(_handle) )
+			const Event* ev = poll();
+			if (isValid(_handle)
+			&&  NULL != ev
+			&&  ev->m_handle.idx != _handle.idx)
+			{
+				return NULL;
+			}
+
+			return ev;
+		}
+
+		void release(const Event* _event)
+		{
+			const uint32_t read = m_read.load(std::memory_order_relaxed);
+			RTM_ASSERT(_event == record(read), "Events must be released in order they were polled!");
+			RTM_UNUSED(_event);
+			advance(read + 1);
+		}
+
+		/// Posts events kept aside by Coalesce policy if there is room, called by producer.
+		void flush()
+		{
+			publishStaged();
+		}
+
+		/// Returns true if events are kept aside, producer should flush again later.
+		bool hasStaged() const
+		{
+			return m_stagedMouse || 0 != m_stagedAxisMask;
+		}
+
+		/// Called by exiting producer before the lane is handed to another thread, events that are
+		/// still kept aside are dropped. Records already posted stay queued for the consumer.
+		void detach()
+		{
+			publishStaged();
+
+			uint32_t numStaged = m_stagedMouse ? 1 : 0;
+			for (uint32_t mask = m_stagedAxisMask; 0 != mask; mask &= mask - 1)
+			{
+				++numStaged;
+			}
+
+			if (0 != numStaged)
+			{
+				m_numDropped.fetch_add(numStaged, std::memory_order_relaxed);
+			}
+
+			m_stagedMouse		= false;
+			m_stagedAxisMask	= 0;
+			m_overflow			= false;
+			m_mouse[0]			= 0;
+			m_mouse[1]			= 0;
+			m_mouse[2]			= 0;
+		}
+
+		void setPolicy(EventOverflow::Enum _policy)
+		{
+			m_policy.store(_policy, std::memory_order_relaxed);
+		}
+
+		void getStats(EventQueueStats& _stats) const
+		{
+			_stats.m_policy			= (EventOverflow::Enum)m_policy.load(std::memory_order_relaxed);
+			_stats.m_capacity		= RAPP_EVENT_QUEUE_SIZE;
+			_stats.m_size			= m_write.load(std::memory_order_relaxed) - m_read.load(std::memory_order_relaxed);
+			_stats.m_highWater		= m_highWater.load(std::memory_order_relaxed);
+			_stats.m_numBlocked		= m_numBlocked.load(std::memory_order_relaxed);
+			_stats.m_numDropped		= m_numDropped.load(std::memory_order_relaxed);
+			_stats.m_numCoalesced	= m_numCoalesced.load(std::memory_order_relaxed);
+			_stats.m_numProducers	= 1;
+		}
+
+		void resetStats()
+		{
+			m_highWater.store(0, std::memory_order_relaxed);
+			m_numBlocked.store(0, std::memory_order_relaxed);
+			m_numDropped.store(0, std::memory_order_relaxed);
+			m_numCoalesced.store(0, std::memory_order_relaxed);
+		}
+
+	private:
+		Event* record(uint32_t _index)
+		{
+			return (Event*)m_records[_index & RAPP_EVENT_QUEUE_MASK].m_data;
+		}
+
+		/// Returns true if event at _read can be skipped, records past it up to _write are owned by consumer.
+		bool superseded(const Event* _event, uint32_t _read, uint32_t _write)
+		{
+			if (_read + 1 == _write)
+			{
+				return false;
+			}
+
+			if (Event::Mouse == _event->m_type)
+			{
+				const MouseEvent* mouse = static_cast<const MouseEvent*>(_event);
+				Event* next = record(_read + 1);
+				if (!mouse->m_move
+				||  Event::Mouse != next->m_type
+				||  !static_cast<MouseEvent*>(next)->m_move
+				||  mouse->m_handle.idx != next->m_handle.idx)
+				{
+					return false;
+				}
+
+				MouseEvent* merged = static_cast<MouseEvent*>(next);
+				merged->m_dx += mouse->m_dx;
+				merged->m_dy += mouse->m_dy;
+				merged->m_dz += mouse->m_dz;
+				m_numCoalesced.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+
+			if (Event::Axis == _event->m_type)
+			{
+				const AxisEvent* axis = static_cast<const AxisEvent*>(_event);
+				const uint32_t end = _write - _read > RAPP_EVENT_COALESCE_SCAN ? _read + RAPP_EVENT_COALESCE_SCAN : _write;
+				for (uint32_t i=_read+1; i!=end; ++i)
+				{
+					const Event* ev = record(i);
+					if (Event::Axis != ev->m_type)
+					{
+						return false;
+					}
+
+					const AxisEvent* next = static_cast<const AxisEvent*>(ev);
+					if (next->m_gamepad.idx == axis->m_gamepad.idx
+					&&  next->m_axis == axis->m_axis)
+					{
+						m_numCoalesced.fetch_add(1, std::memory_order_relaxed);
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
+		void setMouseDelta(MouseEvent* _event)
+		{
+			_event->m_dx = _event->m_mx - m_mouse[0];
+			_event->m_dy = _event->m_my - m_mouse[1];
+			_event->m_dz = _event->m_mz - m_mouse[2];
+			m_mouse[0] = _event->m_mx;
+			m_mouse[1] = _event->m_my;
+			m_mouse[2] = _event->m_mz;
+		}
+
+		/// Consumer side, frees records up to _read and wakes producer blocked on a full queue.
+		void advance(uint32_t _read)
+		{
+			m_read.store(_read, std::memory_order_seq_cst);
+			if (m_waiting.load(std::memory_order_seq_cst) )
 			{
-				Event* ev = 0;
-				m_queue.peek((void**)&ev);
-				if (NULL == ev
-				||  ev->m_handle.idx != _handle.idx)
+				eventQueueWake(&m_read);
+			}
+		}
+
+		/// Returns next free record. Droppable events posted to a full queue go to scratch record when
+		/// policy allows it, otherwise producer waits for consumer.
+		void* slot(bool _droppable)
+		{
+			bool blocked = false;
+			for (;;)
+			{
+				publishStaged();
+
+				const uint32_t write = m_write.load(std::memory_order_relaxed);
+				const uint32_t read  = m_read.load(std::memory_order_acquire);
+				if (!hasStaged() && write - read < RAPP_EVENT_QUEUE_SIZE)
 				{
-					return NULL;
+					return stamp(record(write) );
 				}
+
+				if (_droppable && EventOverflow::Block != m_policy.load(std::memory_order_relaxed) )
+				{
+					m_overflow = true;
+					return m_scratch.m_data;
+				}
+
+				if (!blocked)
+				{
+					blocked = true;
+					m_numBlocked.fetch_add(1, std::memory_order_relaxed);
+				}
+
+				m_waiting.store(1, std::memory_order_seq_cst);
+				if (read == m_read.load(std::memory_order_seq_cst) )
+				{
+					eventQueueWait(&m_read, read);
+				}
+				m_waiting.store(0, std::memory_order_relaxed);
+			}
+		}
+
+		template <typename T>
+		T* alloc(WindowHandle _handle, bool _droppable = false)
+		{
+			RTM_STATIC_ASSERT(sizeof(T) <= EventRecord::kSize);
+			RTM_STATIC_ASSERT(std::is_trivially_destructible<T>::value);
+			return new (slot(_droppable) ) T(_handle);
+		}
+
+		void commit()
+		{
+			if (m_overflow)
+			{
+				m_overflow = false;
+				overflow( (const Event*)m_scratch.m_data);
+				return;
 			}
 
-			return poll();
+			publish();
+		}
+
+		/// Takes sequence number when the record is claimed, event data is written in place after it.
+		void* stamp(Event* _record)
+		{
+			( (EventRecord*)_record)->m_sequence = m_sequence->fetch_add(1, std::memory_order_relaxed);
+			return _record;
 		}
 
-		void release(const Event* _event) const
+		void publish()
 		{
-			delete _event;
+			const uint32_t write = m_write.load(std::memory_order_relaxed);
+			m_write.store(write + 1, std::memory_order_release);
+
+			const uint32_t size = write + 1 - m_read.load(std::memory_order_relaxed);
+			if (size > m_highWater.load(std::memory_order_relaxed) )
+			{
+				m_highWater.store(size, std::memory_order_relaxed);
+			}
+		}
+
+		/// Handles droppable event that didn't fit into the queue.
+		void overflow(const Event* _event)
+		{
+			if (EventOverflow::Coalesce != m_policy.load(std::memory_order_relaxed) )
+			{
+				m_numDropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			if (Event::Mouse == _event->m_type)
+			{
+				MouseEvent* staged = (MouseEvent*)m_stagedMouseRecord.m_data;
+				MouseEvent mouse = *static_cast<const MouseEvent*>(_event);
+				if (m_stagedMouse)
+				{
+					if (staged->m_handle.idx == mouse.m_handle.idx)
+					{
+						mouse.m_dx += staged->m_dx;
+						mouse.m_dy += staged->m_dy;
+						mouse.m_dz += staged->m_dz;
+						m_numCoalesced.fetch_add(1, std::memory_order_relaxed);
+					}
+					else
+					{
+						m_numDropped.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+
+				*staged = mouse;
+				m_stagedMouse = true;
+				return;
+			}
+
+			const AxisEvent* axis = static_cast<const AxisEvent*>(_event);
+			if (axis->m_gamepad.idx >= ENTRY_CONFIG_MAX_GAMEPADS)
+			{
+				m_numDropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			const uint32_t bit = 1u << (axis->m_gamepad.idx * GamepadAxis::Count + axis->m_axis);
+			if (m_stagedAxisMask & bit)
+			{
+				m_numCoalesced.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			m_stagedAxis[axis->m_gamepad.idx][axis->m_axis]		= axis->m_value;
+			m_stagedAxisWindow[axis->m_gamepad.idx][axis->m_axis]	= axis->m_handle;
+			m_stagedAxisMask |= bit;
 		}
 
+		/// Posts events kept aside while queue was full, in order mouse move then axis values.
+		void publishStaged()
+		{
+			if (!hasStaged() )
+			{
+				return;
+			}
+
+			const uint32_t read = m_read.load(std::memory_order_acquire);
+
+			if (m_stagedMouse)
+			{
+				const uint32_t write = m_write.load(std::memory_order_relaxed);
+				if (write - read >= RAPP_EVENT_QUEUE_SIZE)
+				{
+					return;
+				}
+
+				memcpy(stamp(record(write) ), m_stagedMouseRecord.m_data, sizeof(MouseEvent) );
+				m_stagedMouse = false;
+				publish();
+			}
+
+			for (uint32_t index=0; 0 != m_stagedAxisMask; ++index)
+			{
+				if (0 == (m_stagedAxisMask & (1u << index) ) )
+				{
+					continue;
+				}
+
+				const uint32_t write = m_write.load(std::memory_order_relaxed);
+				if (write - read >= RAPP_EVENT_QUEUE_SIZE)
+				{
+					return;
+				}
+
+				const uint32_t gamepad	= index / GamepadAxis::Count;
+				const uint32_t axis		= index % GamepadAxis::Count;
+
+				AxisEvent* ev = new (stamp(record(write) ) ) AxisEvent(m_stagedAxisWindow[gamepad][axis]);
+				ev->m_gamepad.idx	= (uint16_t)gamepad;
+				ev->m_axis			= (GamepadAxis::Enum)axis;
+				ev->m_value			= m_stagedAxis[gamepad][axis];
+				m_stagedAxisMask &= ~(1u << index);
+				publish();
+			}
+		}
+
+	public:
+		std::atomic<uint32_t>*				m_sequence;		// shared by all lanes of a queue
+
 	private:
-		rtm::SpScQueue<void*> m_queue;
+		// producer side
+		int32_t								m_mouse[3];		// last posted mouse position
+		bool								m_overflow;		// last allocated event went to scratch record
+		bool								m_stagedMouse;
+		uint32_t							m_stagedAxisMask;
+		int32_t								m_stagedAxis[ENTRY_CONFIG_MAX_GAMEPADS][GamepadAxis::Count];
+		WindowHandle						m_stagedAxisWindow[ENTRY_CONFIG_MAX_GAMEPADS][GamepadAxis::Count];
+		EventRecord							m_stagedMouseRecord;
+		EventRecord							m_scratch;
+
+		std::atomic<uint8_t>				m_policy;
+		std::atomic<uint32_t>				m_highWater;
+		std::atomic<uint32_t>				m_numBlocked;
+		std::atomic<uint32_t>				m_numDropped;
+		std::atomic<uint32_t>				m_numCoalesced;
+		std::atomic<uint32_t>				m_waiting;		// producer is about to wait on m_read
+
+		alignas(64) std::atomic<uint32_t>	m_write;
+		alignas(64) std::atomic<uint32_t>	m_read;
+		alignas(64) EventRecord				m_records[RAPP_EVENT_QUEUE_SIZE];
+	};
+
+	/// Multiple producer, single consumer event queue. Every posting thread gets its own lane on first
+	/// post and keeps it until it exits, then the lane can be claimed by another thread.
+	/// Platform message loop, gamepad readers, replay and remote input can post from their own threads.
+	/// Events of one producer are delivered in posting order. Lanes are merged by sequence numbers taken
+	/// when records are claimed, so events posted concurrently by different threads may interleave.
+	class EventQueue
+	{
+	public:
+		EventQueue()
+			: m_sequence(0)
+			, m_numLanes(0)
+			, m_numDropped(0)
+			, m_exhausted(false)
+			, m_polled(UINT32_MAX)
+		{
+			for (uint32_t i=0; i<RAPP_EVENT_MAX_PRODUCERS; ++i)
+			{
+				m_lanes[i].m_sequence = &m_sequence;
+				m_owned[i].store(false, std::memory_order_relaxed);
+			}
+
+			m_id = eventQueueRegister(this);
+		}
+
+		~EventQueue()
+		{
+			eventQueueUnregister(this);
+		}
+
+		void postAxisEvent(WindowHandle _handle, GamepadHandle _gamepad, GamepadAxis::Enum _axis, int32_t _value)
+		{
+			EventLane* lane = producerLane();
+			if (NULL != lane)
+				lane->postAxisEvent(_handle, _gamepad, _axis, _value);
+		}
+
+		void postCharEvent(WindowHandle _handle, uint8_t _len, const uint8_t _char[4])
+		{
+			EventLane* lane = producerLane();
+			if (NULL != lane)
+				lane->postCharEvent(_handle, _len, _char);
+		}
+
+		void postExitEvent()
+		{
+			EventLane* lane = producerLane();
+			if (NULL != lane)
+				lane->postExitEvent();
+		}
+
+		void postGamepadEvent(WindowHandle _handle, GamepadHandle _gamepad, bool _connected)
+		{
+			EventLane* lane = producerLane();
+			if (NULL != lane)
+				lane->postGamepadEvent(_handle, _gamepad, _connected);
+		}
+
+		void postGamepadButtonsEvent(WindowHandle _handle, GamepadHandle _gamepad, GamepadButton::Enum _button, bool _pressed)
+		{
+			EventLane* lane = producerLane();
+			if (NULL != lane)
+				lane->postGamepadButtonsEvent(_handle, _gamepad, _button, _pressed);
+		}
+
+		void postKeyEvent(WindowHandle _handle, KeyboardKey::Enum _key, uint8_t _modifiers, bool _down)
+		{
+			EventLane* lane = producerLane();
+			if (NULL != lane)
+				lane->postKeyEvent(_handle, _key, _modifiers, _down);
+		}
+
+		void postMouseEvent(WindowHandle _handle, int32_t _mx, int32_t _my, int32_t _mz, uint8_t _modifiers)
+		{
+			EventLane* lane = producerLane();
+			if (NULL != lane)
+				lane->postMouseEvent(_handle, _mx, _my, _mz, _modifiers);
+		}
+
+		void postMouseEvent(WindowHandle _handle, int32_t _mx, int32_t _my, int32_t _mz, MouseButton::Enum _button, uint8_t _modifiers, bool _down, bool _double)
+		{
+			EventLane* lane = producerLane();
+			if (NULL != lane)
+				lane->postMouseEvent(_handle, _mx, _my, _mz, _button, _modifiers, _down, _double);
+		}
+
+		void postSizeEvent(WindowHandle _handle, uint32_t _width, uint32_t _height)
+		{
+			EventLane* lane = producerLane();
+			if (NULL != lane)
+				lane->postSizeEvent(_handle, _width, _height);
+		}
+
+		void postWindowEvent(WindowHandle _handle, void* _nwh = NULL)
+		{
+			EventLane* lane = producerLane();
+			if (NULL != lane)
+				lane->postWindowEvent(_handle, _nwh);
+		}
+
+		void postSuspendEvent(WindowHandle _handle, SuspendEvent::Enum _suspendState)
+		{
+			EventLane* lane = producerLane();
+			if (NULL != lane)
+				lane->postSuspendEvent(_handle, _suspendState);
+		}
+
+		/// Returns the oldest event at the head of all lanes.
+		const Event* poll()
+		{
+			const Event* result = NULL;
+			const uint32_t numLanes = numActiveLanes();
+			for (uint32_t i=0; i<numLanes; ++i)
+			{
+				const Event* ev = m_lanes[i].poll();
+				if (NULL != ev
+				&& (NULL == result || int32_t(sequence(ev) - sequence(result) ) < 0) )
+				{
+					result		= ev;
+					m_polled	= i;
+				}
+			}
+
+			return result;
+		}
+
+		const Event* poll(WindowHandle _handle)
+		{
+			const Event* ev = poll();
+			if (isValid(_handle)
+			&&  NULL != ev
+			&&  ev->m_handle.idx != _handle.idx)
+			{
+				return NULL;
+			}
+
+			return ev;
+		}
+
+		void release(const Event* _event)
+		{
+			RTM_ASSERT(m_polled < RAPP_EVENT_MAX_PRODUCERS, "Releasing event that wasn't polled!");
+			m_lanes[m_polled].release(_event);
+			m_polled = UINT32_MAX;
+		}
+
+		/// Posts events calling thread kept aside by Coalesce policy.
+		void flush()
+		{
+			EventLane* lane = producerLane(false);
+			if (NULL != lane)
+				lane->flush();
+		}
+
+		/// Returns true if calling thread has events kept aside by Coalesce policy.
+		bool hasStaged()
+		{
+			EventLane* lane = producerLane(false);
+			return NULL != lane && lane->hasStaged();
+		}
+
+		/// Claims a free lane for the calling thread, returns UINT32_MAX if all are taken.
+		uint32_t claimLane()
+		{
+			for (uint32_t i=0; i<RAPP_EVENT_MAX_PRODUCERS; ++i)
+			{
+				bool expected = false;
+				if (!m_owned[i].load(std::memory_order_relaxed)
+				&&  m_owned[i].compare_exchange_strong(expected, true, std::memory_order_acquire) )
+				{
+					uint32_t numLanes = m_numLanes.load(std::memory_order_relaxed);
+					while (numLanes < i + 1
+					&&    !m_numLanes.compare_exchange_weak(numLanes, i + 1, std::memory_order_release) )
+					{
+					}
+
+					return i;
+				}
+			}
+
+			// reported in release builds as well, events of this thread are lost
+			if (!m_exhausted.exchange(true, std::memory_order_relaxed) )
+			{
+				RTM_ERROR("Too many threads posting events, increase RAPP_EVENT_MAX_PRODUCERS!");
+			}
+
+			return UINT32_MAX;
+		}
+
+		/// Called by exiting thread, hands its lane over to the next thread that posts.
+		void releaseLane(uint32_t _lane)
+		{
+			RTM_ASSERT(_lane < RAPP_EVENT_MAX_PRODUCERS && m_owned[_lane].load(std::memory_order_relaxed), "Releasing lane that isn't claimed!");
+			m_lanes[_lane].detach();
+			m_owned[_lane].store(false, std::memory_order_release);
+		}
+
+		void setPolicy(EventOverflow::Enum _policy)
+		{
+			for (uint32_t i=0; i<RAPP_EVENT_MAX_PRODUCERS; ++i)
+			{
+				m_lanes[i].setPolicy(_policy);
+			}
+		}
+
+		void getStats(EventQueueStats& _stats) const
+		{
+			m_lanes[0].getStats(_stats);
+
+			const uint32_t numLanes = numActiveLanes();
+			for (uint32_t i=1; i<numLanes; ++i)
+			{
+				EventQueueStats stats;
+				m_lanes[i].getStats(stats);
+				_stats.m_size			+= stats.m_size;
+				_stats.m_highWater		 = stats.m_highWater > _stats.m_highWater ? stats.m_highWater : _stats.m_highWater;
+				_stats.m_numBlocked		+= stats.m_numBlocked;
+				_stats.m_numDropped		+= stats.m_numDropped;
+				_stats.m_numCoalesced	+= stats.m_numCoalesced;
+			}
+
+			uint32_t numProducers = 0;
+			for (uint32_t i=0; i<numLanes; ++i)
+			{
+				numProducers += m_owned[i].load(std::memory_order_relaxed) ? 1 : 0;
+			}
+
+			_stats.m_numDropped		+= m_numDropped.load(std::memory_order_relaxed);
+			_stats.m_numProducers	 = numProducers;
+		}
+
+		void resetStats()
+		{
+			for (uint32_t i=0; i<RAPP_EVENT_MAX_PRODUCERS; ++i)
+			{
+				m_lanes[i].resetStats();
+			}
+
+			m_numDropped.store(0, std::memory_order_relaxed);
+		}
+
+	private:
+		static uint32_t sequence(const Event* _event)
+		{
+			return ( (const EventRecord*)_event)->m_sequence;
+		}
+
+		uint32_t numActiveLanes() const
+		{
+			const uint32_t numLanes = m_numLanes.load(std::memory_order_acquire);
+			return numLanes < RAPP_EVENT_MAX_PRODUCERS ? numLanes : RAPP_EVENT_MAX_PRODUCERS;
+		}
+
+		/// Returns lane of the calling thread, assigned on first post. Threads that only flush don't claim one.
+		EventLane* producerLane(bool _claim = true)
+		{
+			const uint32_t lane = eventQueueProducerLane(this, m_id, _claim);
+			if (lane < RAPP_EVENT_MAX_PRODUCERS)
+			{
+				return &m_lanes[lane];
+			}
+
+			if (_claim)
+			{
+				m_numDropped.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			return NULL;
+		}
+
+		std::atomic<uint32_t>	m_sequence;
+		std::atomic<uint32_t>	m_numLanes;		// highest lane ever claimed plus one, consumer polls that many
+		std::atomic<uint32_t>	m_numDropped;	// posted by threads beyond RAPP_EVENT_MAX_PRODUCERS
+		std::atomic<bool>		m_exhausted;
+		std::atomic<bool>		m_owned[RAPP_EVENT_MAX_PRODUCERS];
+		uint32_t				m_id;			// distinguishes queues allocated at the same address
+		uint32_t				m_polled;		// lane of the event returned by last poll
+		EventLane				m_lanes[RAPP_EVENT_MAX_PRODUCERS];
 	};
 
 } // namespace rapp
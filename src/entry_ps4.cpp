@@ -591,6 +591,11 @@ namespace rapp
 	{
 		g_eventQueue.release(_event);
 	}
+
+	EventQueue* eventQueueGet()
+	{
+		return &g_eventQueue;
+	}
 	
 	void appRunOnMainThread(ThreadFn _fn, void* _userData)
 	{
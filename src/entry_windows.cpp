@@ -1266,6 +1266,11 @@ namespace rapp
 		s_ctx.m_eventQueue.release(_event);
 	}
 
+	EventQueue* eventQueueGet()
+	{
+		return &s_ctx.m_eventQueue;
+	}
+
 	void appRunOnMainThread(ThreadFn _fn, void* _userData)
 	{
 		PostMessage(s_ctx.m_hwndRapp, WM_USER_CALL_FUNC, (WPARAM)_fn, (LPARAM)_userData);
@@ -522,6 +522,11 @@ namespace rapp
 		g_eventQueue.release(_event);
 	}
 
+	EventQueue* eventQueueGet()
+	{
+		return &g_eventQueue;
+	}
+
 	void appRunOnMainThread(ThreadFn _fn, void* _userData)
 	{
 		RAPP_CMD_WRITE(Command::RunFunc);
@@ -25,6 +25,10 @@
 #include <string>
 
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+#include <rapp/src/task_private.h>
 
 namespace rapp
 {
@@ -104,12 +108,14 @@ namespace rapp
 	{
 		Joystick()
 			: m_fd(-1)
+			, m_retryTime(0)
 		{
 		}
 
 		void init()
 		{
 			m_fd = open("/dev/input/js0", O_RDONLY | O_NONBLOCK);
+			m_retryTime = 0;
 
 			memset(m_value, 0, sizeof(m_value) );
 
@@ -127,7 +133,34 @@ namespace rapp
 			if (-1 != m_fd)
 			{
 				close(m_fd);
+				m_fd = -1;
+			}
+		}
+
+		/// Closes a disconnected device, it's reopened by retry() once plugged back in.
+		void hangup()
+		{
+			shutdown();
+			memset(m_value, 0, sizeof(m_value) );
+		}
+
+		/// Tries to open the device at most once per RAPP_JOYSTICK_RETRY_MS, returns true if it was opened.
+		bool retry()
+		{
+			if (-1 != m_fd)
+			{
+				return false;
 			}
+
+			const uint64_t now = rtm::cpuClock();
+			if (now < m_retryTime)
+			{
+				return false;
+			}
+
+			m_retryTime = now + rtm::cpuFrequency() * RAPP_JOYSTICK_RETRY_MS / 1000;
+			m_fd = open("/dev/input/js0", O_RDONLY | O_NONBLOCK);
+			return -1 != m_fd;
 		}
 
 		bool filter(GamepadAxis::Enum _axis, int32_t* _value)
@@ -148,13 +181,20 @@ namespace rapp
 				return false;
 			}
 
+			bool result = false;
+
 			JoystickEvent event;
-			int32_t bytes = read(m_fd, &event, sizeof(JoystickEvent) );
-			if (bytes != sizeof(JoystickEvent) )
+			while (read(m_fd, &event, sizeof(JoystickEvent) ) == sizeof(JoystickEvent) )
 			{
-				return false;
+				post(_eventQueue, event);
+				result = true;
 			}
 
+			return result;
+		}
+
+		void post(EventQueue& _eventQueue, const JoystickEvent& event)
+		{
 			GamepadHandle handle = { 0 };
 
 			if (event.type & JS_EVENT_BUTTON)
@@ -196,11 +236,10 @@ namespace rapp
 					}
 				}
 			}
-
-			return true;
 		}
 
 		int m_fd;
+		uint64_t m_retryTime;	// cpu clock ticks
 		int32_t m_value[GamepadAxis::Count];
 		int32_t m_deadzone[GamepadAxis::Count];
 	};
@@ -230,6 +269,15 @@ namespace rapp
 	};
 
 	static rtm::SpScQueue<>		s_channel(1024);
+	static int					s_wakeFd = -1;	// signaled to wake main thread blocked in poll
+
+	static void wakeMainThread(void* _userData)
+	{
+		RTM_UNUSED(_userData);
+		uint64_t value = 1;
+		ssize_t written = write(s_wakeFd, &value, sizeof(value));
+		RTM_UNUSED(written);
+	}
 
 	#define RAPP_CMD_READ(_type, _name)		\
 		_type _name;						\
@@ -438,6 +486,9 @@ namespace rapp
 			mte.m_argc = _argc;
 			mte.m_argv = _argv;
 
+			s_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			taskSetMainThreadWake(wakeMainThread, 0);
+
 			rtm::Thread thread;
 			thread.start(mte.threadFunc, &mte);
 
@@ -445,13 +496,18 @@ namespace rapp
 
 			s_joystick.init();
 
+			// Main thread blocks until X connection, joystick or wake eventfd (commands, pinned tasks, quit) is readable.
+			pollfd pfd[3];
+			pfd[0].fd		= ConnectionNumber(m_display);
+			pfd[0].events	= POLLIN;
+			pfd[1].fd		= s_wakeFd;
+			pfd[1].events	= POLLIN;
+			pfd[2].events	= POLLIN;
+
 			while (!m_exit)
 			{
-				bool joystick = s_joystick.update(m_eventQueue);
-				bool xpending = XPending(m_display);
-
 				uintptr_t cmd = 0;
-				if (s_channel.read(&cmd))
+				while (s_channel.read(&cmd))
 				{
 					switch (cmd)
 					{
@@ -476,11 +532,43 @@ namespace rapp
 					};
 				}
 
-				if (!xpending)
+				taskRunPinned(RAPP_TASK_THREAD_MAIN);
+
+				s_joystick.retry();
+				s_joystick.update(m_eventQueue);
+
+				// XPending flushes output buffer and reads whatever is on the connection, events already
+				// buffered by Xlib would not make the fd readable so block only once queue is empty.
+				if (0 == XPending(m_display) )
 				{
-					rtm::threadSleep(joystick ? 8 : 16);
+					if (m_exit)
+					{
+						break;
+					}
+
+					// events kept aside while queue was full are retried shortly
+					m_eventQueue.flush();
+
+					// disconnected joystick is left out of the poll set, wake up periodically to reopen it
+					pfd[2].fd = s_joystick.m_fd;
+					const nfds_t numFds = -1 != s_joystick.m_fd ? 3 : 2;
+					const int32_t timeout = m_eventQueue.hasStaged() ? 1 : (-1 != s_joystick.m_fd ? -1 : RAPP_JOYSTICK_RETRY_MS);
+
+					int32_t ready = poll(pfd, numFds, timeout);
+					if (ready > 0 && (pfd[1].revents & POLLIN) )
+					{
+						uint64_t value;
+						ssize_t bytes = read(s_wakeFd, &value, sizeof(value));
+						RTM_UNUSED(bytes);
+					}
+
+					if (ready > 0 && 3 == numFds && (pfd[2].revents & (POLLHUP | POLLERR | POLLNVAL) ) )
+					{
+						s_joystick.hangup();
+					}
 				}
-				else
+
+				while (XPending(m_display) )
 				{
 					XEvent event;
 					XNextEvent(m_display, &event);
@@ -615,6 +703,10 @@ namespace rapp
 
 			thread.stop();
 
+			taskSetMainThreadWake(0, 0);
+			close(s_wakeFd);
+			s_wakeFd = -1;
+
 			s_joystick.shutdown();
 
 			XDestroyIC(ic);
@@ -670,6 +762,9 @@ namespace rapp
 			XSetClassHint(m_display, window, hint);
 			XFree(hint);
 
+			// requests from other threads are not flushed by main thread blocked in poll
+			XFlush(m_display);
+
 			m_eventQueue.postSizeEvent(_handle, msg->m_width, msg->m_height);
 
 			union cast
@@ -731,6 +826,7 @@ namespace rapp
 		MainThreadEntry* self = (MainThreadEntry*)_userData;
 		int32_t result = main(self->m_argc, self->m_argv);
 		s_ctx.m_exit = true;
+		wakeMainThread(0);
 		return result;
 	}
 
@@ -749,11 +845,17 @@ namespace rapp
 		s_ctx.m_eventQueue.release(_event);
 	}
 
+	EventQueue* eventQueueGet()
+	{
+		return &s_ctx.m_eventQueue;
+	}
+
 	void appRunOnMainThread(ThreadFn _fn, void* _userData)
 	{
 		RAPP_CMD_WRITE(Command::RunFunc);
 		RAPP_CMD_WRITE(_fn);
 		RAPP_CMD_WRITE(_userData);
+		wakeMainThread(0);
 	}
 
 	void windowGetDefaultSize(uint32_t* _width, uint32_t* _height)
@@ -793,6 +895,7 @@ namespace rapp
 			Window w = s_ctx.m_windows.getData(_handle.idx);
 			XUnmapWindow(s_ctx.m_display, w);
 			XDestroyWindow(s_ctx.m_display, w);
+			XFlush(s_ctx.m_display);
 
 			rtm::ScopedMutexLocker scope(s_ctx.m_lock);
 
@@ -817,6 +920,7 @@ namespace rapp
 		Display* display = s_ctx.m_display;
 		Window   window  = s_ctx.m_windows.getData(_handle.idx);
 		XMoveWindow(display, window, _x, _y);
+		XFlush(display);
 	}
 
 	void windowSetSize(WindowHandle _handle, uint32_t _width, uint32_t _height)
@@ -824,6 +928,7 @@ namespace rapp
 		Display* display = s_ctx.m_display;
 		Window   window  = s_ctx.m_windows.getData(_handle.idx);
 		XResizeWindow(display, window, int32_t(_width), int32_t(_height) );
+		XFlush(display);
 	}
 
 	void windowSetTitle(WindowHandle _handle, const char* _title)
@@ -831,6 +936,7 @@ namespace rapp
 		Display* display = s_ctx.m_display;
 		Window   window  = s_ctx.m_windows.getData(_handle.idx);
 		XStoreName(display, window, _title);
+		XFlush(display);
 	}
 
 	void windowToggleFrame(WindowHandle _handle)
@@ -0,0 +1,745 @@
+//--------------------------------------------------------------------------//
+/// Copyright 2025 Milos Tosic. All Rights Reserved.                       ///
+/// License: http://www.opensource.org/licenses/BSD-2-Clause               ///
+//--------------------------------------------------------------------------//
+
+#include <rapp_pch.h>
+#include <rapp/src/rapp_config.h>
+#include <rapp/src/task_private.h>
+
+#include <rbase/inc/thread.h>
+
+#if RTM_PLATFORM_POSIX
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#else
+	#include <stdio.h>
+#endif
+
+#if RTM_PLATFORM_LINUX && RAPP_WITH_IO_URING && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+	#include <linux/io_uring.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#define RAPP_FILE_URING		1
+#endif
+#endif
+
+#ifndef RAPP_FILE_URING
+	#define RAPP_FILE_URING		0
+#endif
+
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+#include <new>
+
+namespace rapp {
+
+	// ------------------------------------------------
+	/// Platform file access
+	// ------------------------------------------------
+
+#if RTM_PLATFORM_POSIX
+	typedef int FileHandle;
+	#define RAPP_FILE_INVALID	(-1)
+	#define RAPP_FILE_NOMEM		(-ENOMEM)
+#else
+	typedef FILE* FileHandle;
+	#define RAPP_FILE_INVALID	(0)
+	#define RAPP_FILE_NOMEM		(-1)
+#endif
+
+	/// Number of reads and streams whose final callback task hasn't finished yet.
+	static std::atomic<uint32_t> s_fileNumPending(0);
+
+	static FileHandle fileOpen(const char* _path)
+	{
+#if RTM_PLATFORM_POSIX
+		return open(_path, O_RDONLY | O_CLOEXEC);
+#else
+		return fopen(_path, "rb");
+#endif
+	}
+
+	static void fileClose(FileHandle _file)
+	{
+		if (_file == RAPP_FILE_INVALID)
+			return;
+#if RTM_PLATFORM_POSIX
+		close(_file);
+#else
+		fclose(_file);
+#endif
+	}
+
+	static uint64_t fileGetSize(FileHandle _file)
+	{
+#if RTM_PLATFORM_POSIX
+		struct stat st;
+		return fstat(_file, &st) == 0 ? (uint64_t)st.st_size : 0;
+#elif RTM_COMPILER_MSVC
+		_fseeki64(_file, 0, SEEK_END);
+		return (uint64_t)_ftelli64(_file);
+#else
+		fseeko(_file, 0, SEEK_END);
+		return (uint64_t)ftello(_file);
+#endif
+	}
+
+	/// Positional read, returns number of bytes read, 0 at end of file or negative error code.
+	static int64_t fileReadAt(FileHandle _file, void* _buffer, uint32_t _size, uint64_t _offset)
+	{
+#if RTM_PLATFORM_POSIX
+		ssize_t bytes;
+		do
+		{
+			bytes = pread(_file, _buffer, _size, (off_t)_offset);
+		} while ((bytes < 0) && (errno == EINTR));
+		return bytes < 0 ? -(int64_t)errno : (int64_t)bytes;
+#else
+		// I/O threads may share a file handle, FILE position is protected by a lock
+		static std::mutex s_lock;
+		std::unique_lock<std::mutex> lock(s_lock);
+#if RTM_COMPILER_MSVC
+		if (_fseeki64(_file, (int64_t)_offset, SEEK_SET))
+#else
+		if (fseeko(_file, (off_t)_offset, SEEK_SET))
+#endif
+			return -1;
+		size_t bytes = fread(_buffer, 1, _size, _file);
+		return (bytes || !ferror(_file)) ? (int64_t)bytes : -1;
+#endif
+	}
+
+	// ------------------------------------------------
+	/// Read requests
+	// ------------------------------------------------
+
+	struct FileRequest;
+	typedef void(*FileCompleteFn)(FileRequest* _request);
+
+	/// A single positional read, completion function is called on I/O thread once it's done.
+	struct FileRequest
+	{
+		FileHandle		m_file;
+		uint8_t*		m_buffer;
+		uint64_t		m_offset;
+		uint32_t		m_size;
+		uint32_t		m_done;		// bytes read so far, short reads are continued
+		int32_t			m_result;	// 0 on success or negative error code
+		FileCompleteFn	m_complete;
+#if RAPP_FILE_URING
+		FileRequest*	m_prevInFlight;	// queued to io_uring, linked so they can be failed over
+		FileRequest*	m_nextInFlight;
+#endif // RAPP_FILE_URING
+	};
+
+	/// Reads on one of I/O pool threads, used when io_uring is not available.
+	static void fileReadBlocking(void* _userData)
+	{
+		FileRequest* req = (FileRequest*)_userData;
+		while (req->m_done < req->m_size)
+		{
+			int64_t bytes = fileReadAt(req->m_file, req->m_buffer + req->m_done, req->m_size - req->m_done, req->m_offset + req->m_done);
+			if (bytes <= 0)
+			{
+				req->m_result = (int32_t)bytes;
+				break;
+			}
+			req->m_done += (uint32_t)bytes;
+		}
+		req->m_complete(req);
+	}
+
+	static void fileSubmitBlocking(FileRequest* _request)
+	{
+		TaskHandle task = taskCreatePinned(fileReadBlocking, _request, RAPP_TASK_THREAD_IO, true, "File read");
+		if (!isValid(task))
+		{
+			// task pool exhausted, read on the submitting thread so the request still completes
+			fileReadBlocking(_request);
+			return;
+		}
+
+		taskSetInternal(task);
+		taskRun(task);
+	}
+
+#if RAPP_FILE_URING
+
+	/// Single io_uring instance, submissions are serialized by a lock and completions
+	/// are reaped by a dedicated thread that launches completion tasks.
+	struct FileUring
+	{
+		int						m_fd;
+		uint32_t				m_entries;
+		std::atomic<uint32_t>*	m_sqHead;
+		std::atomic<uint32_t>*	m_sqTail;
+		uint32_t				m_sqMask;
+		uint32_t*				m_sqArray;
+		io_uring_sqe*			m_sqes;
+		std::atomic<uint32_t>*	m_cqHead;
+		std::atomic<uint32_t>*	m_cqTail;
+		uint32_t				m_cqMask;
+		io_uring_cqe*			m_cqes;
+		void*					m_sqRing;
+		size_t					m_sqRingSize;
+		void*					m_cqRing;
+		size_t					m_cqRingSize;
+		size_t					m_sqesSize;
+		std::mutex				m_lock;
+		FileRequest*			m_inFlight;		// submitted requests, completion not reaped yet
+		std::atomic<uint32_t>	m_numInFlight;	// kept within ring size so completion queue never overflows
+		std::atomic<bool>		m_running;
+		std::atomic<bool>		m_failed;		// completion thread has exited on an error, ring takes no more requests
+		rtm::Thread				m_thread;
+	};
+
+	static FileUring			s_fileUring;
+	static std::atomic<bool>	s_fileUseUring(false);
+
+	static int fileUringEnter(uint32_t _submit, uint32_t _minComplete, uint32_t _flags)
+	{
+		return (int)syscall(__NR_io_uring_enter, s_fileUring.m_fd, _submit, _minComplete, _flags, 0, 0);
+	}
+
+	static bool fileUringInit()
+	{
+		FileUring& ring = s_fileUring;
+
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+
+		ring.m_fd = (int)syscall(__NR_io_uring_setup, RAPP_FILE_URING_ENTRIES, &params);
+		if (ring.m_fd < 0)
+			return false;
+
+		ring.m_entries		= params.sq_entries;
+		ring.m_sqRingSize	= params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+		ring.m_cqRingSize	= params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		ring.m_sqesSize		= params.sq_entries * sizeof(io_uring_sqe);
+
+		bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (singleMap)
+		{
+			if (ring.m_cqRingSize > ring.m_sqRingSize)
+				ring.m_sqRingSize = ring.m_cqRingSize;
+			ring.m_cqRingSize = ring.m_sqRingSize;
+		}
+
+		ring.m_sqRing = mmap(0, ring.m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.m_fd, IORING_OFF_SQ_RING);
+		ring.m_cqRing = singleMap ? ring.m_sqRing : mmap(0, ring.m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.m_fd, IORING_OFF_CQ_RING);
+		ring.m_sqes = (io_uring_sqe*)mmap(0, ring.m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.m_fd, IORING_OFF_SQES);
+
+		if ((ring.m_sqRing == MAP_FAILED) || (ring.m_cqRing == MAP_FAILED) || (ring.m_sqes == MAP_FAILED))
+		{
+			if (ring.m_sqRing != MAP_FAILED)						munmap(ring.m_sqRing, ring.m_sqRingSize);
+			if (!singleMap && (ring.m_cqRing != MAP_FAILED))	munmap(ring.m_cqRing, ring.m_cqRingSize);
+			if (ring.m_sqes != MAP_FAILED)						munmap(ring.m_sqes, ring.m_sqesSize);
+			close(ring.m_fd);
+			ring.m_fd = -1;
+			return false;
+		}
+
+		uint8_t* sq = (uint8_t*)ring.m_sqRing;
+		uint8_t* cq = (uint8_t*)ring.m_cqRing;
+		ring.m_sqHead	= (std::atomic<uint32_t>*)(sq + params.sq_off.head);
+		ring.m_sqTail	= (std::atomic<uint32_t>*)(sq + params.sq_off.tail);
+		ring.m_sqMask	= *(uint32_t*)(sq + params.sq_off.ring_mask);
+		ring.m_sqArray	= (uint32_t*)(sq + params.sq_off.array);
+		ring.m_cqHead	= (std::atomic<uint32_t>*)(cq + params.cq_off.head);
+		ring.m_cqTail	= (std::atomic<uint32_t>*)(cq + params.cq_off.tail);
+		ring.m_cqMask	= *(uint32_t*)(cq + params.cq_off.ring_mask);
+		ring.m_cqes		= (io_uring_cqe*)(cq + params.cq_off.cqes);
+		return true;
+	}
+
+	/// Queues a read (or a wake up no-op for null request), returns false if the ring is full.
+	static bool fileUringSubmit(FileRequest* _request)
+	{
+		FileUring& ring = s_fileUring;
+		std::unique_lock<std::mutex> lock(ring.m_lock);
+
+		if (ring.m_failed.load(std::memory_order_relaxed))
+			return false;
+
+		uint32_t tail = ring.m_sqTail->load(std::memory_order_relaxed);
+		uint32_t head = ring.m_sqHead->load(std::memory_order_acquire);
+		if ((tail - head >= ring.m_entries) || (ring.m_numInFlight.load(std::memory_order_relaxed) >= ring.m_entries))
+			return false;
+		ring.m_numInFlight.fetch_add(1, std::memory_order_relaxed);
+
+		uint32_t index = tail & ring.m_sqMask;
+		io_uring_sqe* sqe = &ring.m_sqes[index];
+		memset(sqe, 0, sizeof(io_uring_sqe));
+		if (_request)
+		{
+			sqe->opcode		= IORING_OP_READ;
+			sqe->fd			= _request->m_file;
+			sqe->off		= _request->m_offset + _request->m_done;
+			sqe->addr		= (uint64_t)(uintptr_t)(_request->m_buffer + _request->m_done);
+			sqe->len		= _request->m_size - _request->m_done;
+
+			_request->m_prevInFlight	= 0;
+			_request->m_nextInFlight	= ring.m_inFlight;
+			if (ring.m_inFlight)
+				ring.m_inFlight->m_prevInFlight = _request;
+			ring.m_inFlight = _request;
+		}
+		else
+			sqe->opcode		= IORING_OP_NOP;
+		sqe->user_data = (uint64_t)(uintptr_t)_request;
+
+		ring.m_sqArray[index] = index;
+		ring.m_sqTail->store(tail + 1, std::memory_order_release);
+
+		int ret;
+		do
+		{
+			ret = fileUringEnter(1, 0, 0);
+		} while ((ret < 0) && (errno == EINTR));
+		return true;
+	}
+
+	static void fileUringUnlink(FileRequest* _request)
+	{
+		FileUring& ring = s_fileUring;
+		std::unique_lock<std::mutex> lock(ring.m_lock);
+
+		if (_request->m_prevInFlight)
+			_request->m_prevInFlight->m_nextInFlight = _request->m_nextInFlight;
+		else
+			ring.m_inFlight = _request->m_nextInFlight;
+
+		if (_request->m_nextInFlight)
+			_request->m_nextInFlight->m_prevInFlight = _request->m_prevInFlight;
+	}
+
+	/// Stops using the ring after completion thread failed, reads it would never complete continue on I/O pool.
+	static void fileUringFail()
+	{
+		FileUring& ring = s_fileUring;
+		FileRequest* req;
+		{
+			std::unique_lock<std::mutex> lock(ring.m_lock);
+			ring.m_failed.store(true, std::memory_order_relaxed);
+			s_fileUseUring.store(false, std::memory_order_relaxed);
+			req = ring.m_inFlight;
+			ring.m_inFlight = 0;
+		}
+
+		while (req)
+		{
+			FileRequest* next = req->m_nextInFlight;
+			fileSubmitBlocking(req);
+			req = next;
+		}
+	}
+
+	static void fileUringComplete(FileRequest* _request, int32_t _res)
+	{
+		fileUringUnlink(_request);
+
+		if (_res < 0)
+		{
+			// kernels without IORING_OP_READ reject it, continue on I/O pool
+			if (_res == -EINVAL)
+			{
+				fileSubmitBlocking(_request);
+				return;
+			}
+			_request->m_result = _res;
+		}
+		else
+		if (_res > 0)
+		{
+			_request->m_done += (uint32_t)_res;
+			if ((_request->m_done < _request->m_size) && fileUringSubmit(_request))
+				return;
+			if (_request->m_done < _request->m_size)
+			{
+				fileSubmitBlocking(_request);
+				return;
+			}
+		}
+
+		_request->m_complete(_request);
+	}
+
+	static int32_t fileUringThreadFunc(void* _userData)
+	{
+		RTM_UNUSED(_userData);
+		taskRegisterThread(RAPP_TASK_THREAD_FILE);
+
+		FileUring& ring = s_fileUring;
+		while (ring.m_running.load(std::memory_order_acquire))
+		{
+			int ret = fileUringEnter(0, 1, IORING_ENTER_GETEVENTS);
+			if ((ret < 0) && (errno != EINTR))
+			{
+				fileUringFail();
+				break;
+			}
+
+			uint32_t head = ring.m_cqHead->load(std::memory_order_relaxed);
+			uint32_t tail = ring.m_cqTail->load(std::memory_order_acquire);
+			while (head != tail)
+			{
+				io_uring_cqe* cqe = &ring.m_cqes[head & ring.m_cqMask];
+				FileRequest* req = (FileRequest*)(uintptr_t)cqe->user_data;
+				int32_t res = cqe->res;
+
+				// release slot before completing, completion may submit again
+				ring.m_cqHead->store(++head, std::memory_order_release);
+				ring.m_numInFlight.fetch_sub(1, std::memory_order_relaxed);
+
+				if (req)
+					fileUringComplete(req, res);
+			}
+		}
+
+		taskUnregisterThread();
+		return 0;
+	}
+
+#endif // RAPP_FILE_URING
+
+	static void fileSubmit(FileRequest* _request)
+	{
+#if RAPP_FILE_URING
+		if (s_fileUseUring.load(std::memory_order_relaxed) && fileUringSubmit(_request))
+			return;
+#endif // RAPP_FILE_URING
+		fileSubmitBlocking(_request);
+	}
+
+	///
+	void fileInit()
+	{
+#if RAPP_FILE_URING
+		s_fileUring.m_inFlight = 0;
+		s_fileUring.m_failed.store(false);
+		s_fileUseUring.store(fileUringInit());
+		if (s_fileUseUring.load())
+		{
+			s_fileUring.m_running.store(true);
+			s_fileUring.m_thread.start(fileUringThreadFunc, 0, 0, "File I/O");
+		}
+#endif // RAPP_FILE_URING
+	}
+
+	///
+	void fileShutdown()
+	{
+		// reads in flight complete through the backend, it has to outlive their callbacks
+		while (s_fileNumPending.load(std::memory_order_acquire))
+			rtm::threadSleep(1);
+
+#if RAPP_FILE_URING
+		FileUring& ring = s_fileUring;
+		if (!ring.m_running.load(std::memory_order_relaxed))
+			return;
+
+		// completion thread that exited on an error can't be woken by a no-op, it's only joined
+		ring.m_running.store(false, std::memory_order_release);
+		while (!fileUringSubmit(0) && !ring.m_failed.load(std::memory_order_relaxed))
+			rtm::threadSleep(1);
+		ring.m_thread.stop();
+
+		if (ring.m_cqRing != ring.m_sqRing)
+			munmap(ring.m_cqRing, ring.m_cqRingSize);
+		munmap(ring.m_sqRing, ring.m_sqRingSize);
+		munmap(ring.m_sqes, ring.m_sqesSize);
+		close(ring.m_fd);
+		ring.m_fd = -1;
+		s_fileUseUring.store(false);
+#endif // RAPP_FILE_URING
+	}
+
+	// ------------------------------------------------
+	/// Whole range reads
+	// ------------------------------------------------
+
+	struct FileRead
+	{
+		FileRequest		m_request;
+		FileReadFn		m_function;
+		void*			m_userData;
+		TaskHandle		m_task;
+	};
+
+	static void fileReadTask(void* _userData, uint32_t _start, uint32_t _end)
+	{
+		RTM_UNUSED_2(_start, _end);
+		FileRead* read = (FileRead*)_userData;
+		FileRequest& req = read->m_request;
+
+		read->m_function(read->m_userData, req.m_buffer, req.m_done, req.m_result);
+
+		fileClose(req.m_file);
+		if (req.m_buffer)
+			rtm_free(req.m_buffer);
+		rtm_delete<FileRead>(read);
+
+		s_fileNumPending.fetch_sub(1, std::memory_order_release);
+	}
+
+	static void fileReadComplete(FileRequest* _request)
+	{
+		FileRead* read = (FileRead*)_request;
+		taskRun(read->m_task);
+	}
+
+	///
+	TaskHandle fileReadAsync(const char* _path, uint64_t _offset, uint32_t _size, FileReadFn _func, void* _userData)
+	{
+		RTM_ASSERT(_func, "File read needs a callback function!");
+
+		FileRead* read = rtm_new<FileRead>();
+		if (!read)
+			return { UINT32_MAX };
+
+		read->m_function	= _func;
+		read->m_userData	= _userData;
+		read->m_task		= taskCreateDeferred(fileReadTask, read, "File read callback");
+
+		if (!isValid(read->m_task))
+		{
+			rtm_delete<FileRead>(read);
+			return { UINT32_MAX };
+		}
+
+		FileRequest& req = read->m_request;
+		req.m_file		= fileOpen(_path);
+		req.m_buffer	= 0;
+		req.m_offset	= _offset;
+		req.m_size		= 0;
+		req.m_done		= 0;
+		req.m_result	= 0;
+		req.m_complete	= fileReadComplete;
+
+		if (req.m_file == RAPP_FILE_INVALID)
+			req.m_result = -1;
+		else
+		{
+			uint64_t fileSize = fileGetSize(req.m_file);
+			uint64_t available = fileSize > _offset ? fileSize - _offset : 0;
+			req.m_size = (uint32_t)((_size && (_size < available)) ? _size : (available < UINT32_MAX ? available : UINT32_MAX));
+			if (req.m_size)
+			{
+				req.m_buffer = (uint8_t*)rtm_alloc(req.m_size);
+				if (!req.m_buffer)
+				{
+					req.m_size		= 0;
+					req.m_result	= RAPP_FILE_NOMEM;
+				}
+			}
+		}
+
+		s_fileNumPending.fetch_add(1, std::memory_order_relaxed);
+
+		TaskHandle task = read->m_task;
+		if (req.m_size)
+			fileSubmit(&req);
+		else
+			taskRun(task);
+
+		return task;
+	}
+
+	// ------------------------------------------------
+	/// Chunked streaming
+	// ------------------------------------------------
+
+	struct FileStream;
+
+	/// Chunk buffer, sequence number n is read into buffer n % number of buffers.
+	struct FileChunk
+	{
+		FileRequest				m_request;
+		FileStream*				m_stream;
+		uint32_t				m_sequence;
+		std::atomic<uint32_t>	m_gate;		// read done and previous chunk delivered
+	};
+
+	struct FileStream
+	{
+		FileHandle		m_file;
+		uint64_t		m_fileSize;
+		uint64_t		m_nextOffset;	// only changed by chunk callbacks, those are serialized
+		uint32_t		m_chunkSize;
+		uint32_t		m_numChunks;
+		uint32_t		m_numIssued;
+		int32_t			m_error;		// open or allocation failure, reported by done task
+		bool			m_failed;
+		FileChunkFn		m_function;
+		void*			m_userData;
+		TaskHandle		m_done;
+		FileChunk*		m_chunks;
+		uint8_t*		m_buffers;
+	};
+
+	static void fileStreamIssue(FileStream* _stream, FileChunk& _chunk, uint32_t _sequence)
+	{
+		uint64_t offset = _stream->m_nextOffset;
+		uint64_t remaining = _stream->m_fileSize - offset;
+
+		_chunk.m_sequence = _sequence;
+		_chunk.m_gate.store(_sequence ? 2 : 1, std::memory_order_relaxed);
+
+		FileRequest& req = _chunk.m_request;
+		req.m_offset	= offset;
+		req.m_size		= remaining < _stream->m_chunkSize ? (uint32_t)remaining : _stream->m_chunkSize;
+		req.m_done		= 0;
+		req.m_result	= 0;
+
+		_stream->m_nextOffset += req.m_size;
+		_stream->m_numIssued++;
+	}
+
+	static void fileStreamChunkTask(void* _userData, uint32_t _start, uint32_t _end);
+
+	static void fileStreamGate(FileChunk& _chunk)
+	{
+		if (_chunk.m_gate.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			TaskHandle task = taskCreate(fileStreamChunkTask, &_chunk, true, "File stream chunk");
+			if (!isValid(task))
+			{
+				fileStreamChunkTask(&_chunk, 0, 1);
+				return;
+			}
+
+			taskSetInternal(task);
+			taskRun(task);
+		}
+	}
+
+	static void fileStreamChunkTask(void* _userData, uint32_t _start, uint32_t _end)
+	{
+		RTM_UNUSED_2(_start, _end);
+		FileChunk& chunk = *(FileChunk*)_userData;
+		FileStream* stream = chunk.m_stream;
+		FileRequest& req = chunk.m_request;
+
+		stream->m_function(stream->m_userData, req.m_buffer, req.m_done, req.m_offset, req.m_result);
+		if (req.m_result < 0)
+			stream->m_failed = true;
+
+		// buffer is free again, reuse it for a chunk further ahead
+		uint32_t next = chunk.m_sequence + 1;
+		if (!stream->m_failed && (stream->m_nextOffset < stream->m_fileSize))
+		{
+			fileStreamIssue(stream, chunk, chunk.m_sequence + stream->m_numChunks);
+			fileSubmit(&req);
+		}
+
+		if (next < stream->m_numIssued)
+			fileStreamGate(stream->m_chunks[next % stream->m_numChunks]);
+		else
+			taskRun(stream->m_done);
+	}
+
+	static void fileStreamReadComplete(FileRequest* _request)
+	{
+		fileStreamGate(*(FileChunk*)_request);
+	}
+
+	static void fileStreamDoneTask(void* _userData, uint32_t _start, uint32_t _end)
+	{
+		RTM_UNUSED_2(_start, _end);
+		FileStream* stream = (FileStream*)_userData;
+
+		if (stream->m_error)
+			stream->m_function(stream->m_userData, 0, 0, 0, stream->m_error);
+
+		fileClose(stream->m_file);
+		if (stream->m_buffers)
+			rtm_free(stream->m_buffers);
+		rtm_free(stream);
+
+		s_fileNumPending.fetch_sub(1, std::memory_order_release);
+	}
+
+	///
+	TaskHandle fileStream(const char* _path, uint32_t _chunkSize, uint32_t _numChunks, FileChunkFn _func, void* _userData)
+	{
+		RTM_ASSERT(_func, "File stream needs a callback function!");
+		RTM_ASSERT(_chunkSize, "Chunk size has to be greater than zero!");
+
+		_numChunks = _numChunks ? _numChunks : 1;
+
+		size_t size = sizeof(FileStream) + sizeof(FileChunk) * _numChunks;
+		FileStream* stream = (FileStream*)rtm_alloc(size);
+		if (!stream)
+			return { UINT32_MAX };
+
+		stream->m_done = taskCreateDeferred(fileStreamDoneTask, stream, "File stream");
+		if (!isValid(stream->m_done))
+		{
+			rtm_free(stream);
+			return { UINT32_MAX };
+		}
+
+		stream->m_file			= fileOpen(_path);
+		stream->m_fileSize		= stream->m_file != RAPP_FILE_INVALID ? fileGetSize(stream->m_file) : 0;
+		stream->m_nextOffset	= 0;
+		stream->m_chunkSize		= _chunkSize;
+		stream->m_numChunks		= _numChunks;
+		stream->m_numIssued		= 0;
+		stream->m_error			= 0;
+		stream->m_failed		= false;
+		stream->m_function		= _func;
+		stream->m_userData		= _userData;
+		stream->m_chunks		= (FileChunk*)(stream + 1);
+		stream->m_buffers		= stream->m_file != RAPP_FILE_INVALID ? (uint8_t*)rtm_alloc((size_t)_chunkSize * _numChunks) : 0;
+
+		s_fileNumPending.fetch_add(1, std::memory_order_relaxed);
+
+		if (stream->m_file == RAPP_FILE_INVALID)
+			stream->m_error = -1;
+		else
+		if (!stream->m_buffers)
+			stream->m_error = RAPP_FILE_NOMEM;
+
+		TaskHandle done = stream->m_done;
+
+		// callback is never called on the calling thread, done task reports the failure
+		if (stream->m_error)
+		{
+			taskRun(done);
+			return done;
+		}
+
+		for (uint32_t i=0; i<_numChunks; ++i)
+		{
+			FileChunk* chunk = new (&stream->m_chunks[i]) FileChunk();
+			chunk->m_stream				= stream;
+			chunk->m_request.m_file		= stream->m_file;
+			chunk->m_request.m_buffer	= stream->m_buffers + (size_t)_chunkSize * i;
+			chunk->m_request.m_complete	= fileStreamReadComplete;
+		}
+
+
+		// issue all before submitting any, first completed chunk may already issue the next one
+		uint32_t numInitial = 0;
+		while ((numInitial < _numChunks) && (stream->m_nextOffset < stream->m_fileSize))
+		{
+			fileStreamIssue(stream, stream->m_chunks[numInitial], numInitial);
+			++numInitial;
+		}
+
+		if (!numInitial)
+			taskRun(done);
+
+		for (uint32_t i=0; i<numInitial; ++i)
+			fileSubmit(&stream->m_chunks[i].m_request);
+
+		return done;
+	}
+
+} // namespace rapp
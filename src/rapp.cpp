@@ -29,6 +29,11 @@ extern vg::Context* g_currentContext;
 #include <emscripten/html5.h>
 #endif // RTM_PLATFORM_EMSCRIPTEN
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #define RAPP_CMD_READ(_type, _name)		\
 	_type _name;						\
 	cc->read(_name)
@@ -56,6 +61,9 @@ struct Command
 		Draw,
 		DrawGUI,
 		Frame,
+		TaskCallbacks,
+		EndBatch,
+		Snapshot,
 		Shutdown,
 
 		Count
@@ -65,6 +73,30 @@ struct Command
 static rtm::CommandBuffer	s_commChannel;		// rapp_main to app class thread communication
 App*						s_app = 0;
 
+static std::atomic<uint32_t>	s_framesIssued(0);	// Frame commands written by rapp_main
+static std::atomic<uint32_t>	s_framesDrawn(0);	// Frame commands processed by app thread
+static std::mutex				s_framesLock;
+static std::condition_variable	s_framesDrawnWake;	// signalled by app thread after each Frame command
+static const void*				s_drawSnapshot = 0;	// app thread only
+#if RTM_DEBUG
+static thread_local bool		s_pipelineUpdating = false;	// pipelined App::update is running on this worker
+#endif // RTM_DEBUG
+static std::mutex				s_appThreadLock;
+static std::condition_variable	s_appThreadWake;			// app thread waits on it between command batches
+static uint32_t					s_appBatchesSubmitted = 0;	// command channel frames, ended by Command::EndBatch
+static bool						s_appWakePending = false;	// tasks were pinned to app thread or app callbacks queued
+static bool						s_appThreadQuit = false;
+
+/// Debug check for functions that have to stay on app thread, pipelined App::update runs on a worker.
+static inline void appAssertNotInUpdate(const char* _function)
+{
+#if RTM_DEBUG
+	RTM_ASSERT(!s_pipelineUpdating, "%s called from pipelined App::update, it runs on a worker thread!", _function);
+#else
+	RTM_UNUSED(_function);
+#endif // RTM_DEBUG
+}
+
 rtm::FixedArray<App*, RAPP_MAX_APPS>& appGetRegistered()
 {
 	static rtm::FixedArray<App*, RAPP_MAX_APPS> apps;
@@ -74,6 +106,7 @@ rtm::FixedArray<App*, RAPP_MAX_APPS>& appGetRegistered()
 static void drawGUI(App* _app)
 {
 	RTM_UNUSED(_app);
+	appAssertNotInUpdate("drawGUI");
 #ifdef RAPP_WITH_BGFX
 	MouseState ms;
 	inputGetMouseState(ms);
@@ -101,142 +134,238 @@ static uint32_t s_debug = 0;
 extern uint32_t g_debug;
 #endif // RAPP_WITH_BGFX
 
-int32_t rappThreadFunc(void* _userData)
+/// Executes a single command read from the channel on app thread.
+static void appThreadCommand(rtm::CommandBuffer* cc, uint8_t _cmd)
 {
-	rtm::CommandBuffer* cc = (rtm::CommandBuffer*)_userData;
-
-	while (cc->dataAvailable())
+	switch (_cmd)
 	{
-		uint8_t cmd = Command::Count;
-		cc->read(cmd);
-
-		switch (cmd)
-		{
-			case Command::Init:
-				{
-					RAPP_CMD_READ(App*, app);
-					RAPP_CMD_READ(int, argc);
-					RAPP_CMD_READ(const char* const*, argv);
-
-					rtmLibInterface libInterface;
-					libInterface.m_error	= g_errorHandler;
-					libInterface.m_memory	= g_allocator;
-					app->init(argc, argv, &libInterface);
-				}
-				break;
+		case Command::Init:
+			{
+				RAPP_CMD_READ(App*, app);
+				RAPP_CMD_READ(int, argc);
+				RAPP_CMD_READ(const char* const*, argv);
+
+				rtmLibInterface libInterface;
+				libInterface.m_error	= g_errorHandler;
+				libInterface.m_memory	= g_allocator;
+				app->init(argc, argv, &libInterface);
+			}
+			break;
 
-			case Command::Suspend:
-				{
-					RAPP_CMD_READ(App*, app);
-					app->suspend();
+		case Command::Suspend:
+			{
+				RAPP_CMD_READ(App*, app);
+				app->suspend();
 
-				}
-				break;
+			}
+			break;
 
-			case Command::Resume:
-				{
-					RAPP_CMD_READ(App*, app);
-					app->resume();
-				}
-				break;
+		case Command::Resume:
+			{
+				RAPP_CMD_READ(App*, app);
+				app->resume();
+			}
+			break;
 
-			case Command::Update:
-				{
-					RAPP_CMD_READ(App*, app);
-					RAPP_CMD_READ(float, time);
-					app->update(time);
-				}
-				break;
+		case Command::Update:
+			{
+				RAPP_CMD_READ(App*, app);
+				RAPP_CMD_READ(float, time);
+				app->update(time);
+			}
+			break;
 
-			case Command::Draw:
-				{
-					RAPP_CMD_READ(App*, app);
-					RAPP_CMD_READ(float, alpha);
+		case Command::Draw:
+			{
+				RAPP_CMD_READ(App*, app);
+				RAPP_CMD_READ(float, alpha);
 #ifdef RAPP_WITH_BGFX
-					if (app->isGUImode())
+				if (app->isGUImode())
+				{
+					if (app->m_resetView)
 					{
-						if (app->m_resetView)
-						{
-							bgfx::reset(app->m_width, app->m_height, g_reset);
-							app->m_resetView = false;
-						}
+						bgfx::reset(app->m_width, app->m_height, g_reset);
+						app->m_resetView = false;
+					}
 
-						// Set view 0 default viewport.
-						bgfx::setViewRect(0, 0, 0, (uint16_t)app->m_width, (uint16_t)app->m_height);
+					// Set view 0 default viewport.
+					bgfx::setViewRect(0, 0, 0, (uint16_t)app->m_width, (uint16_t)app->m_height);
 
-						// This dummy draw call is here to make sure that view 0 is cleared
-						// if no other draw calls are submitted to view 0.
-						bgfx::touch(0);
+					// This dummy draw call is here to make sure that view 0 is cleared
+					// if no other draw calls are submitted to view 0.
+					bgfx::touch(0);
 
-						g_currentContext = app->m_data->m_vg;
+					g_currentContext = app->m_data->m_vg;
 
-						vg::begin(app->m_data->m_vg, 0, uint16_t(app->m_width), uint16_t(app->m_height), 1.0f);
+					vg::begin(app->m_data->m_vg, 0, uint16_t(app->m_width), uint16_t(app->m_height), 1.0f);
 
-						app->draw(alpha);
-					}
-#endif // #RAPP_WITH_BGFX
+					app->draw(alpha);
 				}
-				break;
+#endif // #RAPP_WITH_BGFX
+			}
+			break;
 
-			case Command::DrawGUI:
-				{
-					RAPP_CMD_READ(App*, app);
-					if (app->isGUImode())
-						drawGUI(app);
-				}
-				break;
+		case Command::DrawGUI:
+			{
+				RAPP_CMD_READ(App*, app);
+				if (app->isGUImode())
+					drawGUI(app);
+			}
+			break;
 
-			case Command::Frame:
-				{
-					RAPP_CMD_READ(App*, app);
+		case Command::Frame:
+			{
+				RAPP_CMD_READ(App*, app);
 #ifdef RAPP_WITH_BGFX
-					g_currentContext = 0;
+				g_currentContext = 0;
 
-					if (app->isGUImode())
+				if (app->isGUImode())
+				{
+					bgfx::frame();
+					if (s_debug != g_debug)
 					{
-						bgfx::frame();
-						if (s_debug != g_debug)
-						{
-							bgfx::setDebug(g_debug);
-							s_debug = g_debug;
-						}
+						bgfx::setDebug(g_debug);
+						s_debug = g_debug;
 					}
+				}
 #endif // RAPP_WITH_BGFX
+				frameAdvance();
+				{
+					std::unique_lock<std::mutex> lock(s_framesLock);
+					s_framesDrawn.fetch_add(1, std::memory_order_release);
 				}
-				break;
+				s_framesDrawnWake.notify_one();
+			}
+			break;
 
-			case Command::Shutdown:
-				{
-					RAPP_CMD_READ(App*, app);
-					app->shutDown();
+		case Command::Snapshot:
+			{
+				RAPP_CMD_READ(App*, app);
+				RAPP_CMD_READ(const void*, snapshot);
+				RTM_UNUSED(app);
+				s_drawSnapshot = snapshot;
+			}
+			break;
+
+		case Command::TaskCallbacks:
+			taskRunAppCallbacks();
+			break;
+
+		case Command::Shutdown:
+			{
+				RAPP_CMD_READ(App*, app);
+				app->shutDown();
 #ifdef RAPP_WITH_BGFX
-					g_currentContext = 0;
+				g_currentContext = 0;
 #endif // RAPP_WITH_BGFX
-				}
+			}
+			break;
+
+	default:
+		RTM_ASSERT(false, "Invalid command!");
+	};
+}
+
+int32_t rappThreadFunc(void* _userData)
+{
+	rtm::CommandBuffer* cc = (rtm::CommandBuffer*)_userData;
+
+	// blocks on a wake that is signalled both for command batches and for tasks pinned to app thread,
+	// so pinned tasks don't wait for the next frame of rapp_main
+	uint32_t batches = 0;
+	for (;;)
+	{
+		bool haveBatch;
+		{
+			std::unique_lock<std::mutex> lock(s_appThreadLock);
+			s_appThreadWake.wait(lock, [batches]
+			{
+				return s_appThreadQuit || s_appWakePending || (s_appBatchesSubmitted != batches);
+			});
+
+			s_appWakePending	= false;
+			haveBatch			= s_appBatchesSubmitted != batches;
+			if (s_appThreadQuit)
+				break;
+		}
+
+		taskRunPinned(RAPP_TASK_THREAD_APP);
+		if (taskHasAppCallbacks())
+			taskRunAppCallbacks();
+
+		if (!haveBatch)
+			continue;
+
+		++batches;
+		while (cc->dataAvailable())
+		{
+			taskRunPinned(RAPP_TASK_THREAD_APP);
+
+			uint8_t cmd = Command::Count;
+			cc->read(cmd);
+			if (cmd == Command::EndBatch)
 				break;
 
-		default:
-			RTM_ASSERT(false, "Invalid command!");
-		};
+			appThreadCommand(cc, cmd);
+		}
+	}
+
+	// commands written after the last batch, up to shutdown of the channel
+	while (cc->dataAvailable())
+	{
+		taskRunPinned(RAPP_TASK_THREAD_APP);
+
+		uint8_t cmd = Command::Count;
+		cc->read(cmd);
+		if (cmd != Command::EndBatch)
+			appThreadCommand(cc, cmd);
 	}
 
 	return 0;
 }
 
-void init(rtmLibInterface* _libInterface)
+/// Wakes app thread directly from any thread, it runs pinned tasks and app callbacks right away.
+static void appWakeThread(void* _userData)
+{
+	RTM_UNUSED(_userData);
+	{
+		std::unique_lock<std::mutex> lock(s_appThreadLock);
+		s_appWakePending = true;
+	}
+	s_appThreadWake.notify_one();
+}
+
+/// Ends a batch of commands written by rapp_main and hands it over to app thread.
+static void appSubmitBatch()
+{
+	s_commChannel.write(Command::EndBatch);
+	s_commChannel.frame();
+	{
+		std::unique_lock<std::mutex> lock(s_appThreadLock);
+		++s_appBatchesSubmitted;
+	}
+	s_appThreadWake.notify_one();
+}
+
+void init(rtmLibInterface* _libInterface, const TaskConfig* _taskConfig)
 {
 	g_allocator		= _libInterface ? _libInterface->m_memory : 0;
 	g_errorHandler	= _libInterface ? _libInterface->m_error : 0;
 
-	rapp::taskInit();
+	rapp::taskInit(_taskConfig);
+	rapp::timerInit();
+	rapp::fileInit();
 
 	inputInit();
 
 	if (appGetRegistered().size() > 1)
 		cmdAdd("app", cmdApp, 0, "Application management commands, type 'app help' for more info");
 
+	cmdAdd("tasks", cmdTasks, 0, "Task system commands, type 'tasks help' for more info");
+
 #if !RTM_PLATFORM_EMSCRIPTEN
 	s_commChannel.init(rappThreadFunc);
+	taskSetAppThreadWake(appWakeThread, 0);
 #endif // !RTM_PLATFORM_EMSCRIPTEN
 }
 
@@ -245,9 +374,17 @@ void shutDown()
 	inputShutdown();
 
 #if !RTM_PLATFORM_EMSCRIPTEN
+	taskSetAppThreadWake(0, 0);
+	{
+		std::unique_lock<std::mutex> lock(s_appThreadLock);
+		s_appThreadQuit = true;
+	}
+	s_appThreadWake.notify_one();
 	s_commChannel.shutDown();
 #endif // !RTM_PLATFORM_EMSCRIPTEN
 
+	rapp::fileShutdown();
+	rapp::timerShutdown();
 	rapp::taskShutdown();
 }
 
@@ -260,6 +397,8 @@ App::App(const char* _name, const char* _description)
 	, m_width(0)
 	, m_height(0)
 	, m_frameRate(60)
+	, m_framesInFlight(1)
+	, m_snapshotSize(0)
 	, m_data(0)
 	, m_resetView(false)
 {
@@ -273,6 +412,7 @@ void appRegister(App* _app)
 
 void App::dialogOpen(DialogFn _func, void* _userData)
 {
+	appAssertNotInUpdate("App::dialogOpen");
 #ifdef RAPP_WITH_BGFX
 	if (m_data)
 	{
@@ -293,6 +433,7 @@ void App::dialogOpen(DialogFn _func, void* _userData)
 
 void App::dialogShow()
 {
+	appAssertNotInUpdate("App::dialogShow");
 #ifdef RAPP_WITH_BGFX
 	if (m_data && m_data->m_numDialogs)
 	{
@@ -376,6 +517,201 @@ void appFrame(App* _app)
 {
 	s_commChannel.write(Command::Frame);
 	s_commChannel.write(_app);
+	s_framesIssued.fetch_add(1, std::memory_order_relaxed);
+}
+
+#if !RTM_PLATFORM_EMSCRIPTEN
+/// Pipelined mode state, owned by rapp_main thread. Update of frame N runs on a worker while
+/// frame N-1 is drawn on app thread, each update writes its own snapshot slot.
+struct AppPipeline
+{
+	App*		m_app;
+	uint8_t*	m_snapshots;
+	uint32_t	m_snapshotSize;
+	uint32_t	m_framesInFlight;
+	uint32_t	m_slot;			// snapshot slot written by update in flight
+	TaskHandle	m_update;
+	float		m_steps[RAPP_PIPELINE_MAX_STEPS];	// read by update in flight, refilled only after it's joined
+	uint32_t	m_numSteps;
+	uint32_t	m_numFolded;	// fixed steps merged into the last step of a frame, see RAPP_PIPELINE_MAX_STEPS
+};
+
+static AppPipeline s_pipeline = { 0, 0, 0, 0, 0, { UINT32_MAX }, {}, 0, 0 };
+
+/// Pipelined mode request from appSetPipelined, latched by rapp_main once per frame.
+struct AppPipelineRequest
+{
+	std::mutex	m_lock;
+	App*		m_app;
+	uint32_t	m_framesInFlight;
+	uint32_t	m_snapshotSize;
+};
+
+static AppPipelineRequest s_pipelineRequest;
+
+static void appPipelineLatch(App* _app)
+{
+	std::unique_lock<std::mutex> lock(s_pipelineRequest.m_lock);
+	if (s_pipelineRequest.m_app != _app)
+		return;
+
+	_app->m_framesInFlight		= s_pipelineRequest.m_framesInFlight;
+	_app->m_snapshotSize		= s_pipelineRequest.m_snapshotSize;
+	s_pipelineRequest.m_app		= 0;
+}
+
+static void appWaitFramesDrawn(uint32_t _maxInFlight)
+{
+	std::unique_lock<std::mutex> lock(s_framesLock);
+	s_framesDrawnWake.wait(lock, [_maxInFlight]
+	{
+		return s_framesIssued.load(std::memory_order_relaxed) - s_framesDrawn.load(std::memory_order_acquire) <= _maxInFlight;
+	});
+}
+
+static void appPipelineUpdate(void* _userData, uint32_t _start, uint32_t _end)
+{
+	RTM_UNUSED_2(_start, _end);
+	AppPipeline* pipeline = (AppPipeline*)_userData;
+
+#if RTM_DEBUG
+	uint32_t frame = frameGetIndex();
+	s_pipelineUpdating = true;
+#endif // RTM_DEBUG
+
+	for (uint32_t i=0; i<pipeline->m_numSteps; ++i)
+		pipeline->m_app->update(pipeline->m_steps[i]);
+
+	pipeline->m_app->writeSnapshot(pipeline->m_snapshots + pipeline->m_slot * pipeline->m_snapshotSize);
+
+#if RTM_DEBUG
+	s_pipelineUpdating = false;
+	RTM_ASSERT(frameGetIndex() - frame < RAPP_FRAME_ARENA_FRAMES, "Pipelined update outlived its frame memory!");
+#endif // RTM_DEBUG
+}
+
+/// Waits for update in flight and drawing of snapshots, leaves pipelined mode.
+static void appPipelineFlush()
+{
+	AppPipeline& pipeline = s_pipeline;
+	if (!pipeline.m_app)
+		return;
+
+	if (isValid(pipeline.m_update))
+	{
+		taskWait(pipeline.m_update);
+		taskDestroy(pipeline.m_update);
+		pipeline.m_update = { UINT32_MAX };
+	}
+
+	appWaitFramesDrawn(0);
+
+	// all draws are done, the ones that follow are queued after this and see no snapshot
+	s_commChannel.write(Command::Snapshot);
+	s_commChannel.write(pipeline.m_app);
+	s_commChannel.write((const void*)0);
+
+	rtm_free(pipeline.m_snapshots, 64);
+	pipeline.m_snapshots	= 0;
+	pipeline.m_app			= 0;
+}
+
+/// Runs one pipelined frame, returns true if there is a frame to draw.
+static bool appPipelineFrame(App* _app, FrameStep& _fs)
+{
+	AppPipeline& pipeline = s_pipeline;
+
+	uint32_t framesInFlight = _app->m_framesInFlight < RAPP_PIPELINE_MAX_FRAMES ? _app->m_framesInFlight : RAPP_PIPELINE_MAX_FRAMES;
+	if ((pipeline.m_app != _app) || (pipeline.m_framesInFlight != framesInFlight) || (pipeline.m_snapshotSize != _app->m_snapshotSize))
+	{
+		appPipelineFlush();
+
+		// app init and serial frames have to finish before updates move to workers
+		appWaitFramesDrawn(0);
+
+		uint32_t snapshotSize		= (_app->m_snapshotSize + 63) & ~63;
+		pipeline.m_app				= _app;
+		pipeline.m_snapshotSize		= _app->m_snapshotSize;
+		pipeline.m_framesInFlight	= framesInFlight;
+		pipeline.m_snapshots		= (uint8_t*)rtm_alloc(snapshotSize * framesInFlight + 64, 64);
+		pipeline.m_slot				= 0;
+	}
+
+	// update in flight still reads pipeline steps, collect into a local array until it's joined
+	float steps[RAPP_PIPELINE_MAX_STEPS];
+	uint32_t numSteps = 0;
+	while (_fs.update())
+	{
+		float time = _fs.step();
+		if (numSteps < RAPP_PIPELINE_MAX_STEPS)
+			steps[numSteps++] = time;
+		else
+		{
+			// keeps simulated time in line with serial mode after a hitch
+			steps[RAPP_PIPELINE_MAX_STEPS - 1] += time;
+			++pipeline.m_numFolded;
+		}
+	}
+
+	// updates run in sequence, previous one has produced the snapshot to draw now
+	bool haveFrame = isValid(pipeline.m_update);
+	if (haveFrame)
+	{
+		taskWait(pipeline.m_update);
+		taskDestroy(pipeline.m_update);
+	}
+
+	memcpy(pipeline.m_steps, steps, numSteps * sizeof(float));
+	pipeline.m_numSteps = numSteps;
+
+	uint32_t drawSlot = pipeline.m_slot;
+
+	// next slot was last drawn framesInFlight frames ago, that frame has to be done
+	appWaitFramesDrawn(framesInFlight - 2);
+
+	pipeline.m_slot		= (pipeline.m_slot + 1) % framesInFlight;
+	pipeline.m_update	= taskCreate(appPipelineUpdate, &pipeline, false, "App update");
+	taskSetInternal(pipeline.m_update);
+	taskRun(pipeline.m_update);
+
+	if (haveFrame)
+	{
+		uint32_t snapshotStride = (pipeline.m_snapshotSize + 63) & ~63;
+		s_commChannel.write(Command::Snapshot);
+		s_commChannel.write(_app);
+		s_commChannel.write((const void*)(pipeline.m_snapshots + drawSlot * snapshotStride));
+	}
+
+	return haveFrame;
+}
+#endif // !RTM_PLATFORM_EMSCRIPTEN
+
+void appSetPipelined(App* _app, uint32_t _framesInFlight, uint32_t _snapshotSize)
+{
+#if RTM_PLATFORM_EMSCRIPTEN
+	_app->m_snapshotSize	= _snapshotSize;
+	_app->m_framesInFlight	= _framesInFlight;
+#else
+	// App fields are owned by rapp_main, request is latched at the start of its next frame
+	std::unique_lock<std::mutex> lock(s_pipelineRequest.m_lock);
+	s_pipelineRequest.m_app				= _app;
+	s_pipelineRequest.m_framesInFlight	= _framesInFlight;
+	s_pipelineRequest.m_snapshotSize	= _snapshotSize;
+#endif // RTM_PLATFORM_EMSCRIPTEN
+}
+
+const void* appGetSnapshot(App* _app)
+{
+	RTM_UNUSED(_app);
+	appAssertNotInUpdate("appGetSnapshot");
+	return s_drawSnapshot;
+}
+
+void appTaskCallbacks()
+{
+	// app thread also runs them when woken, this keeps callbacks queued before the frame ordered with its commands
+	if (taskHasAppCallbacks())
+		s_commChannel.write(Command::TaskCallbacks);
 }
 
 #if RTM_PLATFORM_WINDOWS
@@ -516,6 +852,8 @@ static void updateApp()
 
 	if (processEvents(s_app))
 	{
+		taskRunAppCallbacks();
+
 		if (s_app->m_frameRate != fs.frameRate())
 		fs.setFrameRate(s_app->m_frameRate);
 
@@ -572,8 +910,11 @@ static void updateApp()
 		bgfx::frame();
 #endif // RAPP_WITH_BGFX
 
+		frameAdvance();
+
 		if (g_next_app)
 		{
+			taskCancelAll();
 			s_app->shutDown();
 			s_app = g_next_app;
 
@@ -601,24 +942,41 @@ int appRun(App* _app, int _argc, const char* const* _argv)
 	FrameStep fs;
 	while (processEvents(_app))
 	{
+		appTaskCallbacks();
+		appPipelineLatch(_app);
+
 		if (_app->m_frameRate != fs.frameRate())
 			fs.setFrameRate(_app->m_frameRate);
 
-		while (fs.update())
+		bool draw = true;
+		if (_app->m_framesInFlight > 1)
+			draw = appPipelineFrame(_app, fs);
+		else
 		{
-			float time = fs.step();
-			appUpdate(_app, time);
+			appPipelineFlush();
+
+			while (fs.update())
+			{
+				float time = fs.step();
+				appUpdate(_app, time);
+			}
 		}
 
-		appDraw(_app, fs.alpha());
+		if (draw)
+		{
+			appDraw(_app, fs.alpha());
 
-		if (_app->m_width && _app->m_height)
-			appDrawGUI(_app);
+			if (_app->m_width && _app->m_height)
+				appDrawGUI(_app);
 
-		appFrame(_app);
+			appFrame(_app);
+		}
 
 		if (g_next_app)
 		{
+			// speculative work of the app being switched away from is dropped
+			taskCancelAll();
+			appPipelineFlush();
 			appShutDown(_app);
 
 			_app = g_next_app;
@@ -627,8 +985,9 @@ int appRun(App* _app, int _argc, const char* const* _argv)
 			appInit(_app, _argc, _argv);
 		}
 
-		s_commChannel.frame();
+		appSubmitBatch();
 	}
+	appPipelineFlush();
 #endif // RTM_PLATFORM_EMSCRIPTEN
 
 	appShutDown(_app);
@@ -642,7 +1001,10 @@ int rapp_main(int _argc, const char* const* _argv)
 	libInterface.m_error	= rtm::rbaseGetErrorHandler();
 	libInterface.m_memory	= rtm::rbaseGetMemoryManager();
 
-	rapp::init(&libInterface);
+	TaskConfig taskConfig;
+	taskConfigParse(taskConfig, _argc, _argv);
+
+	rapp::init(&libInterface, &taskConfig);
 
 	int ret = rapp::appRun(rapp::appGetRegistered()[0], _argc, _argv);
 	rapp::shutDown();
@@ -8,10 +8,61 @@
 
 #define RAPP_MAX_WINDOWS		2048
 
+#ifndef RAPP_EVENT_QUEUE_SIZE
+#define RAPP_EVENT_QUEUE_SIZE	2048	// power of two, input events are stored in place in a ring of this size per producer
+#endif // RAPP_EVENT_QUEUE_SIZE
+#define RAPP_EVENT_QUEUE_MASK	(RAPP_EVENT_QUEUE_SIZE - 1)
+#define RAPP_EVENT_MAX_PRODUCERS	4		// threads posting input events, each gets its own ring
+#define RAPP_EVENT_MAX_QUEUES		4		// event queues a single thread can post to
+#define RAPP_EVENT_COALESCE_SCAN	32	// queued axis events searched for a newer value of the same axis
+
 #define RAPP_TASKS_PER_THREAD	(16*1024)
 #define RAPP_TASKS_PER_QUEUE	(8*1024)
 #define RAPP_TASKS_QUEUE_MASK	(RAPP_TASKS_PER_QUEUE - 1)
 
+#define RAPP_TASK_INDEX_BITS	16
+#define RAPP_TASK_INDEX_MASK	((1 << RAPP_TASK_INDEX_BITS) - 1)
+#define RAPP_TASK_MAX			((1 << RAPP_TASK_INDEX_BITS) - 1)	// last index reserved, keeps handles != UINT32_MAX
+#define RAPP_TASK_SLAB_SIZE		256
+#define RAPP_TASK_CACHE_SIZE	64
+#define RAPP_TASK_GRAIN_TABLE_SIZE	256		// power of two
+#define RAPP_TASK_GRAIN_TARGET_US	50
+#define RAPP_TASK_TIMING_TABLE_SIZE	256		// power of two, distinct task names timings are recorded for
+
+#define RAPP_TASK_MAX_IO_THREADS	16
+
+#define RAPP_TASK_SPIN_COUNT	256		// yields an idle worker spins for at most before it suspends
+
+#define RAPP_TASK_BATCH_MIN		4		// smaller batches are submitted directly by the caller
+#define RAPP_TASK_BATCH_GRAIN	8		// number of tasks submitted by a single launcher partition
+
+#define RAPP_TIMER_MAX				4096	// less than 0xffff, index is packed into lower half of timer handle
+#define RAPP_TIMER_TICK_US			1000
+#define RAPP_TIMER_WHEEL_BITS		6		// slots per wheel level, as power of two
+#define RAPP_TIMER_WHEEL_LEVELS		4		// 2^24 ticks, longer delays are re-linked when reached
+
+#define RAPP_TASK_GRAPH_MAX_NODES	64
+#define RAPP_TASK_GRAPH_MAX_EDGES	256
+
+#define RAPP_PIPELINE_MAX_FRAMES		3
+#define RAPP_PIPELINE_MAX_STEPS			8		// fixed update steps per frame in pipelined mode, extra steps are folded into the last one
+
+#define RAPP_FRAME_ARENA_SIZE			(256*1024)	// initial per thread frame arena size, grows to high water mark
+#define RAPP_FRAME_ARENA_GRANULARITY	(64*1024)
+#define RAPP_FRAME_ARENA_FRAMES			RAPP_PIPELINE_MAX_FRAMES	// arenas per thread, frame memory outlives the following frames in flight
+
+#define RAPP_PARALLEL_MIN_BLOCK			4096	// minimum number of items per block of parallel algorithms
+#define RAPP_PARALLEL_BLOCKS_PER_THREAD	4
+#define RAPP_PARALLEL_MAX_STRIDE		256		// maximum item size for parallelInclusiveScan
+
+#define RAPP_FILE_URING_ENTRIES			256		// io_uring queue size, reads beyond it go to I/O thread pool
+
+#define RAPP_JOYSTICK_RETRY_MS			1000	// interval at which a missing or disconnected joystick is reopened
+
+#ifndef RAPP_WITH_IO_URING
+#define RAPP_WITH_IO_URING		1		// asynchronous file reads use io_uring on Linux when kernel supports it
+#endif // RAPP_WITH_IO_URING
+
 #ifndef RAPP_WITH_RPROF
 #define RAPP_WITH_RPROF			0
 #endif // RAPP_WITH_RPROF
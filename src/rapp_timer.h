@@ -71,7 +71,41 @@ namespace rapp {
 			return m_accumulator / m_step;
 		}
 	};
-	
+
+	/// Counts fixed length ticks on the same clock FrameStep uses, integer based so it
+	/// doesn't lose precision in long running sessions.
+	class TickClock
+	{
+		uint64_t	m_startClock;
+		uint64_t	m_clocksPerTick;
+		uint32_t	m_tickUs;
+
+	public:
+		TickClock(uint32_t _tickUs = 1000)
+			: m_startClock(rtm::cpuClock())
+			, m_tickUs(_tickUs)
+		{
+			m_clocksPerTick = rtm::cpuFrequency() * _tickUs / 1000000;
+			if (!m_clocksPerTick)
+				m_clocksPerTick = 1;
+		}
+
+		inline uint64_t ticks()
+		{
+			return (rtm::cpuClock() - m_startClock) / m_clocksPerTick;
+		}
+
+		inline uint64_t toTicks(float _seconds)
+		{
+			return _seconds > 0.0f ? (uint64_t)(_seconds * 1000000.0f / float(m_tickUs) + 0.5f) : 0;
+		}
+
+		inline uint32_t tickUs()
+		{
+			return m_tickUs;
+		}
+	};
+
 } // namespace rapp
 
 #endif // RTM_RAPP_TIMER_H
@@ -26,7 +26,13 @@ __pragma(warning(disable:4100))
 __pragma(warning(pop))
 #endif
 
+#include <rbase/inc/thread.h>
+
+#include <stdlib.h>
+#include <string.h>
+
 #include <atomic>
+#include <new>
 #include <thread>
 
 using namespace enki;
@@ -35,178 +41,2816 @@ namespace rapp {
 
 	enki::TaskScheduler g_TS;
 
-	struct CompletionActionDelete : ICompletable
+	static TaskConfig				s_taskConfig;
+	static uint32_t					s_taskFirstWorker		= 0;
+	static uint32_t					s_taskNumCompute		= 1;	// workers plus the thread that initialized the scheduler
+	static uint32_t					s_taskWorkerCpus[64];
+	static uint32_t					s_taskNumWorkerCpus		= 0;
+	static std::atomic<uint32_t>	s_taskSubmitCount(0);
+	static std::atomic<bool>		s_taskSerial(false);
+	static std::atomic<bool>		s_taskRecordTimings(false);
+	static uint32_t					s_taskFirstIoThread		= 0;
+	static uint32_t					s_taskNumIoThreads		= 0;
+	static std::atomic<uint32_t>	s_taskIoPending[RAPP_TASK_MAX_IO_THREADS];
+	static std::atomic<bool>		s_taskIoRunning(false);
+	static rtm::Thread				s_taskIoThreads[RAPP_TASK_MAX_IO_THREADS];
+
+	static inline bool taskIsIoThread(uint32_t _threadNum)
+	{
+		return (_threadNum >= s_taskFirstIoThread) && (_threadNum < s_taskFirstIoThread + s_taskNumIoThreads);
+	}
+
+	/// Per thread scheduler counters, padded to a cache line so threads never share one.
+	struct alignas(64) TaskThreadCounters
+	{
+		std::atomic<uint64_t>	m_numExecuted;
+		std::atomic<uint64_t>	m_numRemote;
+		std::atomic<uint64_t>	m_numSubmitted;
+		std::atomic<uint64_t>	m_numPipeFull;
+		std::atomic<uint64_t>	m_busyTicks;
+		std::atomic<uint64_t>	m_waitTicks;
+		std::atomic<uint64_t>	m_suspendTicks;
+	};
+
+	static TaskThreadCounters		s_taskCounters[RAPP_TASK_MAX_THREADS];
+	static thread_local bool		s_taskSubmitting		= false;
+	static thread_local uint32_t	s_taskInlinePartitions	= 0;
+	static thread_local uint64_t	s_taskWaitClock			= 0;
+	static thread_local uint64_t	s_taskSuspendClock		= 0;
+
+	static inline TaskThreadCounters& taskCounters(uint32_t _threadNum)
+	{
+		return s_taskCounters[_threadNum < RAPP_TASK_MAX_THREADS ? _threadNum : RAPP_TASK_MAX_THREADS - 1];
+	}
+
+	static inline void taskCountExecuted(uint32_t _threadNum, uint64_t _ticks, bool _remote)
+	{
+		TaskThreadCounters& counters = taskCounters(_threadNum);
+		counters.m_numExecuted.fetch_add(1, std::memory_order_relaxed);
+		counters.m_busyTicks.fetch_add(_ticks, std::memory_order_relaxed);
+		if (_remote)
+			counters.m_numRemote.fetch_add(1, std::memory_order_relaxed);
+
+		// partition executed while submitting means enkiTS pipe was full
+		if (s_taskSubmitting)
+			++s_taskInlinePartitions;
+	}
+
+	/// Measured per item cost of a parallel for function, accumulated across runs.
+	struct TaskGrainEntry
+	{
+		std::atomic<uintptr_t>	m_function;
+		std::atomic<uint64_t>	m_ticks;
+		std::atomic<uint64_t>	m_items;
+	};
+
+	class Task;
+
+	/// Runs once a task completes, launches its continuations and releases it if deleted on finish.
+	struct TaskCompletionAction : ICompletable
 	{
 		Dependency    m_Dependency;
-		void OnDependenciesComplete(TaskScheduler* pTaskScheduler_, uint32_t threadNum_)
+		Task*         m_task;
+		void OnDependenciesComplete(TaskScheduler* pTaskScheduler_, uint32_t threadNum_);
+	};
+
+	/// Completable that stays incomplete until signalled, so waiters can block in enkiTS on events
+	/// that are not task completions. It's armed by launching an empty gate task it depends on,
+	/// completion of the gate is ignored and only signal() completes it.
+	class TaskSignal : public ICompletable
+	{
+		class Gate : public enki::ITaskSet
+		{
+		public:
+			void ExecuteRange(enki::TaskSetPartition _range, uint32_t _threadnum) override
+			{
+				RTM_UNUSED_2(_range, _threadnum);
+			}
+		};
+
+		Gate				m_gate;
+		Dependency			m_dependency;
+		std::atomic<bool>	m_signalled;
+
+	public:
+		TaskSignal()
+			: m_signalled(true)
+		{
+			SetDependency(m_dependency, &m_gate);
+		}
+
+		~TaskSignal()
+		{
+			sync();
+		}
+
+		void arm()
+		{
+			sync();
+			m_signalled.store(false, std::memory_order_relaxed);
+			g_TS.AddTaskSetToPipe(&m_gate);
+		}
+
+		void signal(uint32_t _threadNum)
+		{
+			if (!m_signalled.exchange(true, std::memory_order_acq_rel))
+				ICompletable::OnDependenciesComplete(&g_TS, _threadNum);
+		}
+
+		/// Gate has to be done before the signal is re-armed or destroyed.
+		void sync()
+		{
+			if (!m_gate.GetIsComplete())
+				g_TS.WaitforTask(&m_gate);
+		}
+
+	protected:
+		void OnDependenciesComplete(TaskScheduler* _scheduler, uint32_t _threadNum) override
+		{
+			RTM_UNUSED_2(_scheduler, _threadNum);
+		}
+	};
+
+	static std::atomic<uint32_t>	s_taskCancelEpoch(0);
+
+	/// Lifecycle state shared by the task set and the pinned task of a pool slot.
+	struct TaskControl
+	{
+		std::atomic<uint32_t>	m_status;		// RAPP_TASK_STATUS_PENDING until first partition starts, latched on completion
+		std::atomic<bool>		m_cancelled;
+		std::atomic<uint64_t>	m_deadline;		// cpu clock, 0 for no deadline
+		uint32_t				m_epoch;		// s_taskCancelEpoch at creation
+		bool					m_internal;		// created by the framework, never cancelled
+
+		TaskControl()
+			: m_status(RAPP_TASK_STATUS_PENDING)
+			, m_cancelled(false)
+			, m_deadline(0)
+			, m_epoch(0)
+			, m_internal(false)
+		{
+		}
+
+		bool isCancelled()
+		{
+			// internal tasks release resources and launch other internal tasks, they always run
+			if (m_internal)
+				return false;
+
+			if (m_cancelled.load(std::memory_order_relaxed))
+				return true;
+
+			uint64_t deadline = m_deadline.load(std::memory_order_relaxed);
+			if ((deadline && (rtm::cpuClock() >= deadline)) || (m_epoch != s_taskCancelEpoch.load(std::memory_order_relaxed)))
+			{
+				m_cancelled.store(true, std::memory_order_relaxed);
+				return true;
+			}
+
+			return false;
+		}
+
+		/// Called before running a partition, returns false if it should be dropped.
+		bool begin()
+		{
+			if (isCancelled())
+				return false;
+
+			if (m_status.load(std::memory_order_relaxed) == RAPP_TASK_STATUS_PENDING)
+				m_status.store(RAPP_TASK_STATUS_RUNNING, std::memory_order_relaxed);
+			return true;
+		}
+	};
+
+	static thread_local TaskControl*	s_taskCurrent = 0;
+
+	/// Sets task running on calling thread for taskIsCancelled, restored on scope exit as
+	/// waiting inside a task can run other tasks on the same thread.
+	struct TaskCurrentScope
+	{
+		TaskControl* m_previous;
+
+		TaskCurrentScope(TaskControl* _control)
+			: m_previous(s_taskCurrent)
+		{
+			s_taskCurrent = _control;
+		}
+
+		~TaskCurrentScope()
+		{
+			s_taskCurrent = m_previous;
+		}
+	};
+
+	class PinnedTask : public enki::IPinnedTask
+	{
+	public:
+		ThreadFn		m_function;
+		void*			m_userData;
+		const char*		m_name;
+		TaskControl*	m_control;
+
+		PinnedTask()
+			: m_function(0)
+			, m_userData(0)
+			, m_name(0)
+			, m_control(0)
+		{
+		}
+
+		void Execute() override
 		{
-			ICompletable::OnDependenciesComplete(pTaskScheduler_, threadNum_);
-			delete m_Dependency.GetDependencyTask();
+			if (taskIsIoThread(threadNum))
+				s_taskIoPending[threadNum - s_taskFirstIoThread].fetch_sub(1, std::memory_order_relaxed);
+
+			if (!m_control->begin())
+				return;
+
+#if RAPP_WITH_RPROF
+			RPROF_SCOPE(m_name);
+#endif // RAPP_WITH_RPROF
+
+			TaskCurrentScope current(m_control);
+			uint64_t startClock = rtm::cpuClock();
+			m_function(m_userData);
+			taskCountExecuted(threadNum, rtm::cpuClock() - startClock, false);
 		}
 	};
 
+	/// Pool slot, either a task set or a task pinned to a thread (m_pinnedThread != UINT32_MAX).
 	class Task : public enki::ITaskSet
 	{
 	public:
-		CompletionActionDelete	m_taskDeleter;
+		TaskControl				m_control;
+		PinnedTask				m_pinned;		// declared before completion action, dependency on it is cleared first
+		TaskCompletionAction	m_completion;
 		TaskFn					m_function;
+		TaskFnEx				m_functionEx;		// used instead of m_function if set
 		void*					m_userData;
 		uint32_t				m_stride;
 		uint32_t				m_start;
 		uint32_t				m_end;
+		uint32_t				m_index;
+		TaskGrainEntry*			m_grain;
+		uint32_t				m_pinnedThread;
+		uint32_t				m_submitThread;
+		uint64_t				m_submitClock;		// set when timings are recorded
+		const char*				m_name;
+		std::atomic<uint64_t>	m_continuations;	// handle << 32 | first continuation index
+		TaskHandle				m_launcher;			// batch launcher that submits the task, waits go through it first
+		uint32_t				m_nextContinuation;
+		bool					m_deleteOnFinish;
+		std::atomic<bool>		m_launched;
+		bool					m_appCallback;		// m_pinned function is called on app thread instead of running
+		bool					m_deferred;			// run by an external event, waits block on m_deferredDone
+		TaskSignal				m_deferredDone;		// armed while a deferred task hasn't completed
+		std::atomic<bool>		m_finished;			// completion action done, set only if not deleted on finish
+		std::atomic<uint32_t>	m_generation;
+		std::atomic<uint32_t>	m_nextFree;
 
-		Task(uint32_t _numTasks, bool _delete)
-			: enki::ITaskSet(_numTasks)
-			, m_function(0)
+		Task()
+			: m_function(0)
+			, m_functionEx(0)
 			, m_userData(0)
 			, m_stride(0)
 			, m_start(0)
 			, m_end(0)
+			, m_index(0)
+			, m_grain(0)
+			, m_pinnedThread(UINT32_MAX)
+			, m_submitThread(0)
+			, m_submitClock(0)
+			, m_name(0)
+			, m_continuations(0)
+			, m_launcher({ UINT32_MAX })
+			, m_nextContinuation(UINT32_MAX)
+			, m_deleteOnFinish(false)
+			, m_launched(false)
+			, m_appCallback(false)
+			, m_deferred(false)
+			, m_finished(false)
+			, m_generation(1)
+			, m_nextFree(UINT32_MAX)
+		{
+			m_completion.m_task	= this;
+			m_pinned.m_control	= &m_control;
+		}
+
+		ICompletable* completable()
 		{
-			if (_delete)
-				m_taskDeleter.SetDependency(m_taskDeleter.m_Dependency, this);
+			if (m_pinnedThread != UINT32_MAX)
+				return &m_pinned;
+			return this;
 		}
 
 		void ExecuteRange(enki::TaskSetPartition _range, uint32_t _threadnum) override
 		{
-			RTM_UNUSED(_threadnum);
+			// cancelled or past deadline, partitions not started yet are dropped
+			if (!m_control.begin())
+				return;
+
 #if RAPP_WITH_RPROF
-			RPROF_SCOPE("test");
+			RPROF_SCOPE(m_name);
 #endif // RAPP_WITH_RPROF
 
-			m_function(m_userData, _range.start, _range.end);
+			TaskCurrentScope current(&m_control);
+			uint64_t startClock = rtm::cpuClock();
+
+			void* data = m_grain ? (uint8_t*)m_userData + (uintptr_t)_range.start * m_stride : m_userData;
+			if (m_functionEx)
+				m_functionEx(data, _range.start, _range.end, _threadnum);
+			else
+				m_function(data, _range.start, _range.end);
+
+			uint64_t ticks = rtm::cpuClock() - startClock;
+			if (m_grain)
+			{
+				m_grain->m_ticks.fetch_add(ticks, std::memory_order_relaxed);
+				m_grain->m_items.fetch_add(_range.end - _range.start, std::memory_order_relaxed);
+			}
+
+			taskCountExecuted(_threadnum, ticks, _threadnum != m_submitThread);
 		}
 	};
 
-#if RAPP_WITH_RPROF
-	static void rprofCallbackThreadStart(uint32_t _threadNum)
+	/// Slab allocated pool of task objects. Slabs are never returned to the heap until shutdown so
+	/// task objects are always safe to dereference, stale handles are detected by generation mismatch.
+	/// Free slots are cached per thread, batches overflow to a global lock-free list (tagged to avoid ABA).
+	struct TaskPool
 	{
-		RTM_UNUSED(_threadNum);
+		std::atomic<Task*>		m_slabs[(RAPP_TASK_MAX + RAPP_TASK_SLAB_SIZE - 1) / RAPP_TASK_SLAB_SIZE];
+		std::atomic<uint32_t>	m_numTasks;
+		std::atomic<uint32_t>	m_capacity;
+		std::atomic<uint64_t>	m_freeList;
+		std::atomic<uint32_t>	m_numLive;
+		std::atomic<uint32_t>	m_numAllocations;
+		rtm::Mutex				m_growLock;
+	};
+
+	static TaskPool s_taskPool;
+
+	static inline Task* taskPoolAt(uint32_t _index)
+	{
+		Task* slab = s_taskPool.m_slabs[_index / RAPP_TASK_SLAB_SIZE].load(std::memory_order_acquire);
+		return slab ? &slab[_index % RAPP_TASK_SLAB_SIZE] : 0;
 	}
-	static void rprofCallbackThreadEnd(uint32_t _threadNum)
+
+	static void taskPoolPushGlobal(const uint32_t* _indices, uint32_t _count);
+
+	/// Per thread cache of free slots, returned to the global list when the thread exits so slots
+	/// released by timer, file and I/O threads are not stranded.
+	struct TaskCache
 	{
-		RTM_UNUSED(_threadNum);
+		uint32_t	m_count;
+		uint32_t	m_indices[RAPP_TASK_CACHE_SIZE];
+
+		TaskCache() : m_count(0) {}
+
+		~TaskCache()
+		{
+			flush();
+		}
+
+		void flush()
+		{
+			// pool may have been shut down already, slabs and free list are gone then
+			if (m_count && taskPoolAt(m_indices[0]))
+				taskPoolPushGlobal(m_indices, m_count);
+			m_count = 0;
+		}
+	};
+
+	static thread_local TaskCache s_taskCache;
+
+	static void taskPoolInit()
+	{
+		for (uint32_t i=0; i<RTM_NUM_ELEMENTS(s_taskPool.m_slabs); ++i)
+			s_taskPool.m_slabs[i].store(0, std::memory_order_relaxed);
+
+		s_taskPool.m_numTasks.store(0, std::memory_order_relaxed);
+		s_taskPool.m_capacity.store(0, std::memory_order_relaxed);
+		s_taskPool.m_freeList.store(UINT32_MAX, std::memory_order_relaxed);
+		s_taskPool.m_numLive.store(0, std::memory_order_relaxed);
+		s_taskPool.m_numAllocations.store(0, std::memory_order_relaxed);
 	}
-	static void rprofCallbackWaitNewTaskSuspendStart(uint32_t _threadNum)
+
+	static void taskPoolShutdown()
 	{
-		RTM_UNUSED(_threadNum);
+		for (uint32_t i=0; i<RTM_NUM_ELEMENTS(s_taskPool.m_slabs); ++i)
+		{
+			Task* slab = s_taskPool.m_slabs[i].load(std::memory_order_relaxed);
+			if (!slab)
+				continue;
+
+			for (uint32_t t=0; t<RAPP_TASK_SLAB_SIZE; ++t)
+				slab[t].~Task();
+			rtm_free(slab, 64);
+
+			s_taskPool.m_slabs[i].store(0, std::memory_order_relaxed);
+		}
+
+		// worker, timer, file and I/O threads have exited and flushed their caches by now
+		s_taskCache.m_count = 0;
+		s_taskPool.m_freeList.store(UINT32_MAX, std::memory_order_relaxed);
 	}
-	static void rprofCallbackWaitNewTaskSuspendStop(uint32_t _threadNum)
+
+	static bool taskPoolGrow(uint32_t _index)
 	{
-		RTM_UNUSED(_threadNum);
+		if (_index >= RAPP_TASK_MAX)
+			return false;
+
+		const uint32_t slabIndex = _index / RAPP_TASK_SLAB_SIZE;
+		if (s_taskPool.m_slabs[slabIndex].load(std::memory_order_acquire))
+			return true;
+
+		rtm::ScopedMutexLocker lock(s_taskPool.m_growLock);
+		if (s_taskPool.m_slabs[slabIndex].load(std::memory_order_relaxed))
+			return true;
+
+		Task* slab = (Task*)rtm_alloc(sizeof(Task) * RAPP_TASK_SLAB_SIZE, 64);
+		RTM_ASSERT(slab, "Failed to allocate task pool slab!");
+		if (!slab)
+			return false;
+
+		for (uint32_t t=0; t<RAPP_TASK_SLAB_SIZE; ++t)
+		{
+			new (&slab[t]) Task();
+			slab[t].m_index = slabIndex * RAPP_TASK_SLAB_SIZE + t;
+		}
+
+		s_taskPool.m_numAllocations.fetch_add(1, std::memory_order_relaxed);
+		s_taskPool.m_capacity.fetch_add(RAPP_TASK_SLAB_SIZE, std::memory_order_relaxed);
+		s_taskPool.m_slabs[slabIndex].store(slab, std::memory_order_release);
+		return true;
 	}
-	static void rprofCallbackWaitTaskCompleteStart(uint32_t _threadNum)
+
+	static uint32_t taskPoolPopGlobal()
 	{
-		RTM_UNUSED(_threadNum);
+		uint64_t head = s_taskPool.m_freeList.load(std::memory_order_acquire);
+		while ((uint32_t)head != UINT32_MAX)
+		{
+			Task* task = taskPoolAt((uint32_t)head);
+			uint64_t next = (((head >> 32) + 1) << 32) | task->m_nextFree.load(std::memory_order_relaxed);
+			if (s_taskPool.m_freeList.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire))
+				return (uint32_t)head;
+		}
+		return UINT32_MAX;
 	}
-	static void rprofCallbackWaitTaskCompleteStop(uint32_t _threadNum)
+
+	static void taskPoolPushGlobal(const uint32_t* _indices, uint32_t _count)
 	{
-		RTM_UNUSED(_threadNum);
+		for (uint32_t i=0; i<_count-1; ++i)
+			taskPoolAt(_indices[i])->m_nextFree.store(_indices[i+1], std::memory_order_relaxed);
+
+		Task* last = taskPoolAt(_indices[_count-1]);
+		uint64_t head = s_taskPool.m_freeList.load(std::memory_order_relaxed);
+		uint64_t next;
+		do
+		{
+			last->m_nextFree.store((uint32_t)head, std::memory_order_relaxed);
+			next = (((head >> 32) + 1) << 32) | _indices[0];
+		} while (!s_taskPool.m_freeList.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
 	}
-	static void rprofCallbackWaitTaskCompleteSuspendStart(uint32_t _threadNum)
+
+	static Task* taskPoolAcquire()
 	{
-		RTM_UNUSED(_threadNum);
+		uint32_t index = UINT32_MAX;
+
+		if (s_taskCache.m_count)
+			index = s_taskCache.m_indices[--s_taskCache.m_count];
+
+		if (index == UINT32_MAX)
+			index = taskPoolPopGlobal();
+
+		if (index == UINT32_MAX)
+		{
+			index = s_taskPool.m_numTasks.fetch_add(1, std::memory_order_relaxed);
+			if (!taskPoolGrow(index))
+			{
+				RTM_ASSERT(index < RAPP_TASK_MAX, "Task pool exhausted, more than %d live tasks!", RAPP_TASK_MAX);
+
+				// slab allocation failed, give the index back unless another thread took the next one
+				uint32_t next = index + 1;
+				if (index < RAPP_TASK_MAX)
+					s_taskPool.m_numTasks.compare_exchange_strong(next, index, std::memory_order_relaxed);
+				return 0;
+			}
+		}
+
+		s_taskPool.m_numLive.fetch_add(1, std::memory_order_relaxed);
+		return taskPoolAt(index);
 	}
-	static void rprofCallbackWaitTaskCompleteSuspendStop(uint32_t _threadNum)
+
+	static void taskPoolRelease(Task* _task)
 	{
-		RTM_UNUSED(_threadNum);
+		// invalidate outstanding handles before the slot can be reused
+		uint32_t generation = (_task->m_generation.load(std::memory_order_relaxed) + 1) & 0xffff;
+		_task->m_generation.store(generation ? generation : 1, std::memory_order_release);
+
+		s_taskPool.m_numLive.fetch_sub(1, std::memory_order_relaxed);
+
+		if (s_taskCache.m_count == RAPP_TASK_CACHE_SIZE)
+		{
+			s_taskCache.m_count -= RAPP_TASK_CACHE_SIZE / 2;
+			taskPoolPushGlobal(&s_taskCache.m_indices[s_taskCache.m_count], RAPP_TASK_CACHE_SIZE / 2);
+		}
+
+		s_taskCache.m_indices[s_taskCache.m_count++] = _task->m_index;
 	}
-#endif // RAPP_WITH_RPROF
 
-	static void* rprofAllocFunc(size_t _alignment, size_t _size, void* _userData, const char* _file, int _line)
+	static inline TaskHandle taskPoolHandle(Task* _task)
 	{
-		RTM_UNUSED_3(_userData, _file, _line);
-		RTM_ASSERT(_alignment <= 64, "");
-		if (_size >= 2048)
-			_alignment = 64;
-		else
-			_alignment =  8;
-		return rtm_alloc(_size, _alignment);
+		return { (_task->m_generation.load(std::memory_order_relaxed) << RAPP_TASK_INDEX_BITS) | _task->m_index };
 	}
 
-	static void  rprofFreeFunc(void* _ptr, size_t _size, void* _userData, const char* _file, int _line)
+	static inline Task* taskPoolGet(TaskHandle _handle)
 	{
-		RTM_UNUSED_4(_size, _userData, _file, _line);
-		size_t alignment = 8;
-		if (_size >= 2048)
-			alignment = 64;
-		rtm_free(_ptr, alignment);
+		if (!isValid(_handle))
+			return 0;
+
+		Task* task = taskPoolAt(_handle.idx & RAPP_TASK_INDEX_MASK);
+		if (!task || (task->m_generation.load(std::memory_order_acquire) != (_handle.idx >> RAPP_TASK_INDEX_BITS)))
+			return 0;
+
+		return task;
 	}
 
-	/// 
-	void taskInit()
+	#define RAPP_TASK_CONTINUATION_NONE		0xffffffff
+	#define RAPP_TASK_CONTINUATION_CLOSED	0xfffffffe
+
+	static std::atomic<uint32_t>	s_taskAppCallbacks(RAPP_TASK_CONTINUATION_NONE);
+
+	static void taskPrepare(Task* _task, bool _deleteOnFinish)
 	{
-		TaskSchedulerConfig config;
-#if RAPP_WITH_RPROF
-		config.profilerCallbacks.threadStart						= rprofCallbackThreadStart;
-		config.profilerCallbacks.threadStop							= rprofCallbackThreadEnd;
-		config.profilerCallbacks.waitForNewTaskSuspendStart			= rprofCallbackWaitNewTaskSuspendStart;
-		config.profilerCallbacks.waitForNewTaskSuspendStop			= rprofCallbackWaitNewTaskSuspendStop;
-		config.profilerCallbacks.waitForTaskCompleteStart			= rprofCallbackWaitTaskCompleteStart;
-		config.profilerCallbacks.waitForTaskCompleteStop			= rprofCallbackWaitTaskCompleteStop;
-		config.profilerCallbacks.waitForTaskCompleteSuspendStart	= rprofCallbackWaitTaskCompleteSuspendStart;
-		config.profilerCallbacks.waitForTaskCompleteSuspendStop		= rprofCallbackWaitTaskCompleteSuspendStop;
-#endif // RAPP_WITH_RPROF
+		_task->m_deleteOnFinish		= _deleteOnFinish;
+		_task->m_launched			= false;
+		_task->m_control.m_status.store(RAPP_TASK_STATUS_PENDING, std::memory_order_relaxed);
+		_task->m_control.m_cancelled.store(false, std::memory_order_relaxed);
+		_task->m_control.m_deadline.store(0, std::memory_order_relaxed);
+		_task->m_control.m_epoch	= s_taskCancelEpoch.load(std::memory_order_relaxed);
+		_task->m_control.m_internal	= false;
+		_task->m_appCallback		= false;
+		_task->m_deferred			= false;
+		_task->m_submitClock		= 0;
+		_task->m_nextContinuation	= RAPP_TASK_CONTINUATION_NONE;
+		_task->m_launcher			= { UINT32_MAX };
+		_task->m_finished.store(false, std::memory_order_relaxed);
+		_task->m_continuations.store(((uint64_t)taskPoolHandle(_task).idx << 32) | RAPP_TASK_CONTINUATION_NONE, std::memory_order_release);
+		_task->m_completion.SetDependency(_task->m_completion.m_Dependency, _task->completable());
+	}
 
-		config.customAllocator.alloc	= rprofAllocFunc;
-		config.customAllocator.free		= rprofFreeFunc;
-		config.customAllocator.userData = 0;
+	static void taskWakeThread(uint32_t _thread);
 
-		g_TS.Initialize(config);
+	static void taskLaunch(Task* _task)
+	{
+		if (!_task->m_appCallback)
+		{
+			taskRun(taskPoolHandle(_task));
+			return;
+		}
+
+		uint32_t head = s_taskAppCallbacks.load(std::memory_order_relaxed);
+		do
+		{
+			_task->m_nextContinuation = head;
+		} while (!s_taskAppCallbacks.compare_exchange_weak(head, _task->m_index, std::memory_order_release, std::memory_order_relaxed));
+
+		taskWakeThread(RAPP_TASK_THREAD_APP);
 	}
 
-	/// 
-	void taskShutdown()
+	/// Finds or inserts an entry keyed by a pointer, lock-free open addressing with linear probing.
+	/// Returns null if the table is full.
+	template <typename Entry, uint32_t Size>
+	static Entry* taskTableFind(Entry (&_table)[Size], std::atomic<uintptr_t> Entry::* _key, uintptr_t _value, uint32_t _hash)
 	{
-		g_TS.WaitforAllAndShutdown();
+		static_assert((Size & (Size - 1)) == 0, "Table size has to be a power of two");
+
+		for (uint32_t i=0; i<Size; ++i)
+		{
+			Entry& entry = _table[(_hash + i) & (Size - 1)];
+			uintptr_t current = (entry.*_key).load(std::memory_order_acquire);
+
+			// failed CAS loads the winning key into current
+			if ((current == 0) && (entry.*_key).compare_exchange_strong(current, _value, std::memory_order_acq_rel))
+				return &entry;
+
+			if (current == _value)
+				return &entry;
+		}
+		return 0;
 	}
 
-	/// 
-	TaskHandle taskCreate(TaskFn _func, void* _userData, bool _deleteOnFinish)
+	struct TaskTimingEntry
+	{
+		std::atomic<uintptr_t>	m_name;
+		std::atomic<uint64_t>	m_numSerial;
+		std::atomic<uint64_t>	m_serialTicks;
+		std::atomic<uint64_t>	m_numParallel;
+		std::atomic<uint64_t>	m_parallelTicks;
+	};
+
+	static TaskTimingEntry s_timingTable[RAPP_TASK_TIMING_TABLE_SIZE];
+
+	/// Finds or inserts timing entry for a task name, keyed by name pointer.
+	static TaskTimingEntry* taskTimingFind(const char* _name)
 	{
-		return taskCreateGroup(_func, _userData, 0, 1, _deleteOnFinish);
+		const uintptr_t key = (uintptr_t)_name;
+		return taskTableFind(s_timingTable, &TaskTimingEntry::m_name, key, (uint32_t)((key >> 3) * 2654435761u));
 	}
 
-	/// 
-	TaskHandle taskCreateGroup(TaskFn _func, void* _userData, uint32_t _dataStride, uint32_t _numTasks, bool _deleteOnFinish)
+	/// Accumulates task time, serial time is execution cost and parallel time is submission to completion.
+	static void taskTimingAdd(const char* _name, uint64_t _ticks, bool _serial)
 	{
-		Task* j = new Task(_numTasks, _deleteOnFinish);
-		j->m_function	= _func;
-		j->m_userData	= _userData;
-		j->m_stride		= _dataStride;
-		j->m_start		= 0;
-		j->m_end		= _numTasks;
-		return { (uintptr_t)j };
+		TaskTimingEntry* entry = taskTimingFind(_name);
+		if (!entry)
+			return;
+
+		if (_serial)
+		{
+			entry->m_numSerial.fetch_add(1, std::memory_order_relaxed);
+			entry->m_serialTicks.fetch_add(_ticks, std::memory_order_relaxed);
+		}
+		else
+		{
+			entry->m_numParallel.fetch_add(1, std::memory_order_relaxed);
+			entry->m_parallelTicks.fetch_add(_ticks, std::memory_order_relaxed);
+		}
 	}
 
-	/// 
-	void taskDestroy(TaskHandle _task)
+	/// Closes continuation list, continuations added from now on are launched directly by taskThen.
+	static uint32_t taskCloseContinuations(Task* _task)
 	{
-		Task* j = (Task*)_task.idx;
-		if (!j->GetIsComplete())
-			g_TS.WaitforTask(j);
-		delete j;
+		uint64_t head = _task->m_continuations.load(std::memory_order_acquire);
+		while (!_task->m_continuations.compare_exchange_weak(head, (head & 0xffffffff00000000ULL) | RAPP_TASK_CONTINUATION_CLOSED, std::memory_order_acq_rel, std::memory_order_acquire));
+		return (uint32_t)head;
 	}
 
-	/// 
-	void taskRun(TaskHandle _task)
+	/// Launches continuations and releases task if deleted on finish.
+	static void taskFinish(Task* _task, uint32_t _continuations)
 	{
-		Task* j = (Task*)_task.idx;
-		g_TS.AddTaskSetToPipe(j);
+		uint32_t next = _continuations;
+		while (next != RAPP_TASK_CONTINUATION_NONE)
+		{
+			Task* continuation = taskPoolAt(next);
+			next = continuation->m_nextContinuation;
+			taskLaunch(continuation);
+		}
+
+		if (_task->m_deleteOnFinish)
+			taskPoolRelease(_task);
+		else
+			_task->m_finished.store(true, std::memory_order_release);
 	}
 
-	/// 
-	void taskWait(TaskHandle _task)
+	/// Registered by taskWaitAny, signalled by completion of any of its tasks.
+	struct TaskWaitSink
 	{
-		Task* j = (Task*)_task.idx;
-		g_TS.WaitforTask(j);
+		TaskSignal			m_signal;
+		const TaskHandle*	m_tasks;
+		uint32_t			m_count;
+		TaskWaitSink*		m_next;
+	};
+
+	static rtm::Mutex				s_taskWaitLock;
+	static TaskWaitSink*			s_taskWaitSinks = 0;
+	static std::atomic<uint32_t>	s_taskNumWaitSinks(0);
+
+	/// Signals sinks waiting on a task that just completed, called before the task can be released.
+	static void taskWaitSinksSignal(Task* _task, uint32_t _threadNum)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!s_taskNumWaitSinks.load(std::memory_order_relaxed))
+			return;
+
+		const uint32_t handle = taskPoolHandle(_task).idx;
+
+		rtm::ScopedMutexLocker lock(s_taskWaitLock);
+		for (TaskWaitSink* sink = s_taskWaitSinks; sink; sink = sink->m_next)
+		{
+			for (uint32_t i=0; i<sink->m_count; ++i)
+				if (sink->m_tasks[i].idx == handle)
+				{
+					sink->m_signal.signal(_threadNum);
+					break;
+				}
+		}
 	}
 
-	/// 
-	uint32_t taskStatus(TaskHandle _task)
+	void TaskCompletionAction::OnDependenciesComplete(TaskScheduler* pTaskScheduler_, uint32_t threadNum_)
+	{
+		Task* task = m_task;
+
+		if (task->m_submitClock)
+			taskTimingAdd(task->m_name, rtm::cpuClock() - task->m_submitClock, false);
+
+		// later taskCancel calls must not change the outcome
+		task->m_control.m_status.store(task->m_control.m_cancelled.load(std::memory_order_relaxed) ? RAPP_TASK_STATUS_CANCELLED : RAPP_TASK_STATUS_COMPLETE, std::memory_order_release);
+
+		uint32_t continuations = taskCloseContinuations(task);
+		ICompletable::OnDependenciesComplete(pTaskScheduler_, threadNum_);
+		taskWaitSinksSignal(task, threadNum_);
+		if (task->m_deferred)
+			task->m_deferredDone.signal(threadNum_);
+		taskFinish(task, continuations);
+	}
+
+	/// Serial mode, runs the whole task set on the calling thread and completes it right away.
+	static void taskRunInline(Task* _task, uint32_t _threadNum)
+	{
+		_task->m_submitThread = _threadNum;
+
+		enki::TaskSetPartition range;
+		range.start	= 0;
+		range.end	= _task->m_SetSize;
+
+		uint64_t startClock = rtm::cpuClock();
+		_task->ExecuteRange(range, _threadNum);
+		if (s_taskRecordTimings.load(std::memory_order_relaxed))
+			taskTimingAdd(_task->m_name, rtm::cpuClock() - startClock, true);
+
+		uint32_t continuations = taskCloseContinuations(_task);
+		taskWaitSinksSignal(_task, _threadNum);
+		if (_task->m_deferred)
+			_task->m_deferredDone.signal(_threadNum);
+		taskFinish(_task, continuations);
+	}
+
+	static std::atomic<bool>		s_taskRunning(false);
+	static std::atomic<uint32_t>	s_taskPinnedRunners(0);
+	static thread_local bool		s_taskThreadRegistered = false;
+	static ThreadFn					s_mainThreadWakeFn			= 0;
+	static void*					s_mainThreadWakeUserData	= 0;
+	static std::atomic<bool>		s_mainThreadWakePending(false);
+	static ThreadFn					s_appThreadWakeFn			= 0;
+	static void*					s_appThreadWakeUserData		= 0;
+	static thread_local bool		s_taskWakeBatching			= false;	// batch launcher collects wakes
+	static thread_local uint32_t	s_taskWakeMask				= 0;		// 1 main, 2 app thread
+
+	/// Maps named threads to enkiTS thread numbers, main and app threads occupy external thread slots.
+	static uint32_t taskThreadNum(uint32_t _thread)
+	{
+		if (_thread == RAPP_TASK_THREAD_MAIN)
+			return enki::TaskScheduler::GetNumFirstExternalTaskThread();
+		if (_thread == RAPP_TASK_THREAD_APP)
+			return enki::TaskScheduler::GetNumFirstExternalTaskThread() + 1;
+		if (_thread == RAPP_TASK_THREAD_TIMER)
+			return enki::TaskScheduler::GetNumFirstExternalTaskThread() + 2;
+		if (_thread == RAPP_TASK_THREAD_FILE)
+			return enki::TaskScheduler::GetNumFirstExternalTaskThread() + 3;
+		return _thread;
+	}
+
+	/// Picks I/O thread with the fewest queued blocking tasks.
+	static uint32_t taskIoThreadPick()
+	{
+		uint32_t best		= 0;
+		uint32_t bestCount	= UINT32_MAX;
+		for (uint32_t i=0; i<s_taskNumIoThreads; ++i)
+		{
+			uint32_t count = s_taskIoPending[i].load(std::memory_order_relaxed);
+			if (count < bestCount)
+			{
+				best		= i;
+				bestCount	= count;
+			}
+		}
+
+		s_taskIoPending[best].fetch_add(1, std::memory_order_relaxed);
+		return s_taskFirstIoThread + best;
+	}
+
+	/// Wakes an I/O thread during shutdown.
+	class TaskIoWake : public enki::IPinnedTask
 	{
-		Task* j = (Task*)_task.idx;
-		return j->GetIsComplete() ? RAPP_TASK_STATUS_COMPLETE : RAPP_TASK_STATUS_RUNNING;
+	public:
+		void Execute() override {}
+	};
+
+	/// I/O threads are external scheduler threads that only run pinned tasks, blocking in
+	/// them leaves worker threads free for CPU bound tasks.
+	static int32_t taskIoThreadFunc(void* _userData)
+	{
+		uint32_t threadNum = (uint32_t)(uintptr_t)_userData;
+		if (!g_TS.RegisterExternalTaskThread(threadNum))
+			return 1;
+
+		while (s_taskIoRunning.load(std::memory_order_acquire))
+		{
+			g_TS.WaitForNewPinnedTasks();
+			g_TS.RunPinnedTasks();
+		}
+		g_TS.RunPinnedTasks();
+
+		g_TS.DeRegisterExternalTaskThread();
+		return 0;
+	}
+
+	static void taskRunPinnedMainFallback(void* _userData)
+	{
+		RTM_UNUSED(_userData);
+		s_mainThreadWakePending.store(false);
+		taskRunPinned(RAPP_TASK_THREAD_MAIN);
+	}
+
+	static void taskWakeThread(uint32_t _thread)
+	{
+		if (s_taskWakeBatching)
+		{
+			s_taskWakeMask |= (_thread == RAPP_TASK_THREAD_MAIN ? 1 : 0) | (_thread == RAPP_TASK_THREAD_APP ? 2 : 0);
+			return;
+		}
+
+		if (_thread == RAPP_TASK_THREAD_APP)
+		{
+			// app thread runs pinned tasks and app callbacks as soon as it's woken
+			if (s_appThreadWakeFn)
+				s_appThreadWakeFn(s_appThreadWakeUserData);
+			return;
+		}
+
+		if (_thread != RAPP_TASK_THREAD_MAIN)
+			return;	// workers are woken by enkiTS
+
+		if (s_mainThreadWakeFn)
+			s_mainThreadWakeFn(s_mainThreadWakeUserData);
+		else
+		if (!s_mainThreadWakePending.exchange(true))
+			appRunOnMainThread(taskRunPinnedMainFallback, 0);
+	}
+
+	static TaskGrainEntry s_grainTable[RAPP_TASK_GRAIN_TABLE_SIZE];
+
+	/// Finds or inserts cost entry for a function, keyed by function pointer.
+	static TaskGrainEntry* taskGrainFind(const void* _func)
+	{
+		const uintptr_t key = (uintptr_t)_func;
+		return taskTableFind(s_grainTable, &TaskGrainEntry::m_function, key, (uint32_t)((key >> 4) * 2654435761u));
+	}
+
+	/// Picks partition size so a partition takes roughly RAPP_TASK_GRAIN_TARGET_US while still
+	/// leaving enough partitions for all the workers to steal from.
+	static uint32_t taskGrainSize(TaskGrainEntry* _entry, uint32_t _count, uint32_t _minGrain)
+	{
+		uint32_t grain = 1;
+
+		uint64_t items = _entry ? _entry->m_items.load(std::memory_order_relaxed) : 0;
+		if (items)
+		{
+			uint64_t ticks = _entry->m_ticks.load(std::memory_order_relaxed);
+
+			// decay old measurements so cost follows changes in workload, CAS on items lets only one
+			// caller decay and both halvings keep the amounts workers add in the meantime
+			if ((items > (1 << 20)) && _entry->m_items.compare_exchange_strong(items, items / 2, std::memory_order_relaxed))
+			{
+				uint64_t current = _entry->m_ticks.load(std::memory_order_relaxed);
+				while (!_entry->m_ticks.compare_exchange_weak(current, current / 2, std::memory_order_relaxed));
+			}
+
+			uint64_t targetTicks	= rtm::cpuFrequency() * RAPP_TASK_GRAIN_TARGET_US / 1000000;
+			uint64_t ticksPerItem	= ticks / items;
+			uint64_t costGrain		= ticksPerItem ? targetTicks / ticksPerItem : _count;
+
+			uint32_t numPartitions	= s_taskNumCompute * 4;
+			uint64_t balanceGrain	= _count / numPartitions;
+
+			grain = (uint32_t)(costGrain < balanceGrain ? costGrain : balanceGrain);
+			grain = grain ? grain : 1;
+		}
+
+		return grain > _minGrain ? grain : (_minGrain ? _minGrain : 1);
+	}
+
+	class TaskGraphNode : public enki::ITaskSet
+	{
+	public:
+		TaskFn		m_function;
+		void*		m_userData;
+		const char*	m_name;
+
+		TaskGraphNode()
+			: m_function(0)
+			, m_userData(0)
+			, m_name(0)
+		{
+		}
+
+		void ExecuteRange(enki::TaskSetPartition _range, uint32_t _threadnum) override
+		{
+#if RAPP_WITH_RPROF
+			RPROF_SCOPE(m_name);
+#endif // RAPP_WITH_RPROF
+
+			uint64_t startClock = rtm::cpuClock();
+			m_function(m_userData, _range.start, _range.end);
+			taskCountExecuted(_threadnum, rtm::cpuClock() - startClock, false);
+		}
+	};
+
+	/// Empty task launching all the nodes without incoming edges.
+	class TaskGraphRoot : public enki::ITaskSet
+	{
+	public:
+		void ExecuteRange(enki::TaskSetPartition _range, uint32_t _threadnum) override
+		{
+			RTM_UNUSED_2(_range, _threadnum);
+		}
+	};
+
+	/// Completes once all the nodes without outgoing edges have completed.
+	struct TaskGraphSink : ICompletable
+	{
+	};
+
+	struct TaskGraph
+	{
+		struct Edge
+		{
+			uint16_t	m_from;
+			uint16_t	m_to;
+		};
+
+		TaskGraphRoot	m_root;
+		TaskGraphSink	m_sink;
+		TaskGraphNode	m_nodes[RAPP_TASK_GRAPH_MAX_NODES];
+		Edge			m_edges[RAPP_TASK_GRAPH_MAX_EDGES];
+		Dependency		m_dependencies[RAPP_TASK_GRAPH_MAX_EDGES + RAPP_TASK_GRAPH_MAX_NODES * 2];
+		uint16_t		m_order[RAPP_TASK_GRAPH_MAX_NODES];	// topological order, used in serial mode
+		uint32_t		m_numNodes;
+		uint32_t		m_numEdges;
+		uint32_t		m_numDependencies;
+		bool			m_dirty;
+		bool			m_launched;
+
+		TaskGraph()
+			: m_numNodes(0)
+			, m_numEdges(0)
+			, m_numDependencies(0)
+			, m_dirty(true)
+			, m_launched(false)
+		{
+		}
+	};
+
+	static void taskGraphSync(TaskGraph* _graph)
+	{
+		if (_graph->m_launched && !_graph->m_sink.GetIsComplete())
+			g_TS.WaitforTask(&_graph->m_sink);
+	}
+
+	/// Translates edges to enkiTS dependencies, done once after graph topology changes.
+	static void taskGraphBuild(TaskGraph* _graph)
+	{
+		for (uint32_t i=0; i<_graph->m_numDependencies; ++i)
+			_graph->m_dependencies[i].ClearDependency();
+		_graph->m_numDependencies = 0;
+
+		uint32_t numIncoming[RAPP_TASK_GRAPH_MAX_NODES];
+		bool hasOutgoing[RAPP_TASK_GRAPH_MAX_NODES];
+		for (uint32_t i=0; i<_graph->m_numNodes; ++i)
+		{
+			numIncoming[i] = 0;
+			hasOutgoing[i] = false;
+		}
+
+		for (uint32_t i=0; i<_graph->m_numEdges; ++i)
+		{
+			const TaskGraph::Edge& edge = _graph->m_edges[i];
+			Dependency& dep = _graph->m_dependencies[_graph->m_numDependencies++];
+			_graph->m_nodes[edge.m_to].SetDependency(dep, &_graph->m_nodes[edge.m_from]);
+			++numIncoming[edge.m_to];
+			hasOutgoing[edge.m_from] = true;
+		}
+
+		// Kahn's algorithm, every node has to be visited for the graph to be acyclic
+		uint16_t* queue = _graph->m_order;
+		uint32_t incoming[RAPP_TASK_GRAPH_MAX_NODES];
+		uint32_t head = 0;
+		uint32_t tail = 0;
+		for (uint32_t i=0; i<_graph->m_numNodes; ++i)
+		{
+			incoming[i] = numIncoming[i];
+			if (!incoming[i])
+				queue[tail++] = (uint16_t)i;
+		}
+
+		while (head < tail)
+		{
+			uint32_t node = queue[head++];
+			for (uint32_t i=0; i<_graph->m_numEdges; ++i)
+				if ((_graph->m_edges[i].m_from == node) && (--incoming[_graph->m_edges[i].m_to] == 0))
+					queue[tail++] = _graph->m_edges[i].m_to;
+		}
+		RTM_ASSERT(tail == _graph->m_numNodes, "Task graph contains a cycle!");
+
+		for (uint32_t i=0; i<_graph->m_numNodes; ++i)
+		{
+			if (!numIncoming[i])
+				_graph->m_nodes[i].SetDependency(_graph->m_dependencies[_graph->m_numDependencies++], &_graph->m_root);
+
+			if (!hasOutgoing[i])
+				_graph->m_sink.SetDependency(_graph->m_dependencies[_graph->m_numDependencies++], &_graph->m_nodes[i]);
+		}
+
+		_graph->m_dirty = false;
+	}
+
+#if RAPP_WITH_RPROF
+	static char						s_rprofThreadNames[RAPP_TASK_MAX_THREADS][32];
+	static thread_local uintptr_t	s_rprofScopeSuspend			= 0;
+	static thread_local uintptr_t	s_rprofScopeWait			= 0;
+	static thread_local uintptr_t	s_rprofScopeWaitSuspend		= 0;
+#endif // RAPP_WITH_RPROF
+
+	static void taskSetWorkerAffinity(uint32_t _threadNum)
+	{
+		if (!s_taskNumWorkerCpus || (_threadNum < s_taskFirstWorker))
+			return;
+
+#if RTM_PLATFORM_LINUX
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(s_taskWorkerCpus[(_threadNum - s_taskFirstWorker) % s_taskNumWorkerCpus], &cpuSet);
+		pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+#endif // RTM_PLATFORM_LINUX
+	}
+
+	/// Keeps an idle worker spinning until new work is submitted, spin time runs out or it has yielded
+	/// RAPP_TASK_SPIN_COUNT times, then lets enkiTS suspend it. Called right before enkiTS blocks on its
+	/// semaphore, a submission made meanwhile has already signalled it so the worker continues without
+	/// a kernel wake up.
+	static void taskSpinForWork()
+	{
+		if (s_taskConfig.m_waitPolicy != RAPP_TASK_WAIT_SPIN)
+			return;
+
+		uint32_t submitCount	= s_taskSubmitCount.load(std::memory_order_relaxed);
+		uint64_t endClock		= rtm::cpuClock() + rtm::cpuFrequency() * s_taskConfig.m_spinTimeUs / 1000000;
+
+		for (uint32_t spin=0; spin<RAPP_TASK_SPIN_COUNT; ++spin)
+		{
+			if ((s_taskSubmitCount.load(std::memory_order_relaxed) != submitCount) || (rtm::cpuClock() >= endClock))
+				return;
+			std::this_thread::yield();
+		}
+	}
+
+	static void profilerCallbackThreadStart(uint32_t _threadNum)
+	{
+		taskSetWorkerAffinity(_threadNum);
+#if RAPP_WITH_RPROF
+		if (_threadNum >= RTM_NUM_ELEMENTS(s_rprofThreadNames))
+			return;
+
+		char* name = s_rprofThreadNames[_threadNum];
+		snprintf(name, sizeof(s_rprofThreadNames[0]), "Task worker %u", _threadNum);
+		rprofRegisterThread(name);
+#endif // RAPP_WITH_RPROF
+	}
+	static void profilerCallbackThreadEnd(uint32_t _threadNum)
+	{
+		RTM_UNUSED(_threadNum);
+#if RAPP_WITH_RPROF
+		rprofUnregisterThread(rtm::threadGetID());
+#endif // RAPP_WITH_RPROF
+	}
+	static void profilerCallbackWaitNewTaskSuspendStart(uint32_t _threadNum)
+	{
+		RTM_UNUSED(_threadNum);
+		taskSpinForWork();
+		s_taskSuspendClock = rtm::cpuClock();
+#if RAPP_WITH_RPROF
+		s_rprofScopeSuspend = rprofBeginScope(__FILE__, __LINE__, "Task worker idle (suspended)");
+#endif // RAPP_WITH_RPROF
+	}
+	static void profilerCallbackWaitNewTaskSuspendStop(uint32_t _threadNum)
+	{
+		taskCounters(_threadNum).m_suspendTicks.fetch_add(rtm::cpuClock() - s_taskSuspendClock, std::memory_order_relaxed);
+#if RAPP_WITH_RPROF
+		if (s_rprofScopeSuspend)
+			rprofEndScope(s_rprofScopeSuspend);
+		s_rprofScopeSuspend = 0;
+#endif // RAPP_WITH_RPROF
+	}
+	static void profilerCallbackWaitTaskCompleteStart(uint32_t _threadNum)
+	{
+		RTM_UNUSED(_threadNum);
+		s_taskWaitClock = rtm::cpuClock();
+#if RAPP_WITH_RPROF
+		s_rprofScopeWait = rprofBeginScope(__FILE__, __LINE__, "Task wait");
+#endif // RAPP_WITH_RPROF
+	}
+	static void profilerCallbackWaitTaskCompleteStop(uint32_t _threadNum)
+	{
+		taskCounters(_threadNum).m_waitTicks.fetch_add(rtm::cpuClock() - s_taskWaitClock, std::memory_order_relaxed);
+#if RAPP_WITH_RPROF
+		if (s_rprofScopeWait)
+			rprofEndScope(s_rprofScopeWait);
+		s_rprofScopeWait = 0;
+#endif // RAPP_WITH_RPROF
+	}
+	static void profilerCallbackWaitTaskCompleteSuspendStart(uint32_t _threadNum)
+	{
+		RTM_UNUSED(_threadNum);
+		s_taskSuspendClock = rtm::cpuClock();
+#if RAPP_WITH_RPROF
+		s_rprofScopeWaitSuspend = rprofBeginScope(__FILE__, __LINE__, "Task wait (suspended)");
+#endif // RAPP_WITH_RPROF
+	}
+	static void profilerCallbackWaitTaskCompleteSuspendStop(uint32_t _threadNum)
+	{
+		taskCounters(_threadNum).m_suspendTicks.fetch_add(rtm::cpuClock() - s_taskSuspendClock, std::memory_order_relaxed);
+#if RAPP_WITH_RPROF
+		if (s_rprofScopeWaitSuspend)
+			rprofEndScope(s_rprofScopeWaitSuspend);
+		s_rprofScopeWaitSuspend = 0;
+#endif // RAPP_WITH_RPROF
+	}
+
+	/// Per thread linear allocator, reset by its owner thread on first allocation in a frame it's used
+	/// for. Each thread rotates through RAPP_FRAME_ARENA_FRAMES arenas by frame index so memory of
+	/// frame N is recycled only after frame N + RAPP_FRAME_ARENA_FRAMES - 1 has ended.
+	/// Requests that don't fit go to overflow blocks, arena is then resized to the frame high water mark.
+	struct FrameArena
+	{
+		struct Overflow
+		{
+			Overflow*	m_next;
+			uint32_t	m_align;
+		};
+
+		uint8_t*	m_buffer;
+		uint32_t	m_size;
+		uint32_t	m_offset;
+		uint32_t	m_frame;
+		uint32_t	m_highWater;
+		Overflow*	m_overflow;
+
+		FrameArena()
+			: m_buffer(0)
+			, m_size(0)
+			, m_offset(0)
+			, m_frame(0)
+			, m_highWater(0)
+			, m_overflow(0)
+		{
+		}
+
+		~FrameArena()
+		{
+			freeOverflow();
+			if (m_buffer)
+				rtm_free(m_buffer, 64);
+		}
+
+		void freeOverflow()
+		{
+			while (m_overflow)
+			{
+				Overflow* next = m_overflow->m_next;
+				rtm_free(m_overflow, m_overflow->m_align);
+				m_overflow = next;
+			}
+		}
+
+		void reset(uint32_t _frame)
+		{
+			if (m_overflow || !m_buffer)
+			{
+				freeOverflow();
+
+				uint32_t size = m_highWater > RAPP_FRAME_ARENA_SIZE ? m_highWater : RAPP_FRAME_ARENA_SIZE;
+				size = (size + RAPP_FRAME_ARENA_GRANULARITY - 1) & ~(RAPP_FRAME_ARENA_GRANULARITY - 1);
+
+				if (m_buffer)
+					rtm_free(m_buffer, 64);
+				// on failure every allocation goes to overflow, buffer is retried next frame
+				m_buffer	= (uint8_t*)rtm_alloc(size, 64);
+				m_size		= m_buffer ? size : 0;
+			}
+
+			m_offset	= 0;
+			m_highWater	= 0;
+			m_frame		= _frame;
+		}
+
+		void* alloc(uint32_t _size, uint32_t _align)
+		{
+			m_highWater += _size + _align;
+
+			uintptr_t base	= (uintptr_t)m_buffer;
+			uintptr_t ptr	= (base + m_offset + _align - 1) & ~(uintptr_t)(_align - 1);
+			if (m_buffer && (ptr + _size <= base + m_size))
+			{
+				m_offset = (uint32_t)(ptr + _size - base);
+				return (void*)ptr;
+			}
+
+			uint32_t align		= _align < 16 ? 16 : _align;
+			uint32_t header		= (sizeof(Overflow) + align - 1) & ~(align - 1);
+			Overflow* overflow	= (Overflow*)rtm_alloc(header + _size, align);
+			if (!overflow)
+				return 0;
+
+			overflow->m_next	= m_overflow;
+			overflow->m_align	= align;
+			m_overflow			= overflow;
+			return (uint8_t*)overflow + header;
+		}
+	};
+
+	static std::atomic<uint32_t>		s_frameIndex(1);
+	static thread_local FrameArena		s_frameArenas[RAPP_FRAME_ARENA_FRAMES];
+
+	/// 
+	void frameAdvance()
+	{
+		s_frameIndex.fetch_add(1, std::memory_order_release);
+		timerFrameAdvance();
+	}
+
+	/// 
+	void* frameAlloc(uint32_t _size, uint32_t _align)
+	{
+		RTM_ASSERT((_align & (_align - 1)) == 0, "Alignment has to be a power of two!");
+
+		uint32_t frame = s_frameIndex.load(std::memory_order_acquire);
+		FrameArena& arena = s_frameArenas[frame % RAPP_FRAME_ARENA_FRAMES];
+		if (arena.m_frame != frame)
+			arena.reset(frame);
+
+		return arena.alloc(_size, _align);
+	}
+
+	/// 
+	uint32_t frameGetIndex()
+	{
+		return s_frameIndex.load(std::memory_order_acquire);
+	}
+
+	static void* rprofAllocFunc(size_t _alignment, size_t _size, void* _userData, const char* _file, int _line)
+	{
+		RTM_UNUSED_3(_userData, _file, _line);
+		RTM_ASSERT(_alignment <= 64, "");
+		if (_size >= 2048)
+			_alignment = 64;
+		else
+			_alignment =  8;
+		return rtm_alloc(_size, _alignment);
+	}
+
+	static void  rprofFreeFunc(void* _ptr, size_t _size, void* _userData, const char* _file, int _line)
+	{
+		RTM_UNUSED_4(_size, _userData, _file, _line);
+		size_t alignment = 8;
+		if (_size >= 2048)
+			alignment = 64;
+		rtm_free(_ptr, alignment);
+	}
+
+	/// 
+	void taskInit(const TaskConfig* _config)
+	{
+		s_taskConfig = _config ? *_config : TaskConfig();
+		s_taskSerial.store(s_taskConfig.m_serial);
+		s_taskRecordTimings.store(s_taskConfig.m_recordTimings);
+
+		TaskSchedulerConfig config;
+		config.profilerCallbacks.threadStart						= profilerCallbackThreadStart;
+		config.profilerCallbacks.threadStop							= profilerCallbackThreadEnd;
+		config.profilerCallbacks.waitForNewTaskSuspendStart			= profilerCallbackWaitNewTaskSuspendStart;
+		config.profilerCallbacks.waitForNewTaskSuspendStop			= profilerCallbackWaitNewTaskSuspendStop;
+		config.profilerCallbacks.waitForTaskCompleteStart			= profilerCallbackWaitTaskCompleteStart;
+		config.profilerCallbacks.waitForTaskCompleteStop			= profilerCallbackWaitTaskCompleteStop;
+		config.profilerCallbacks.waitForTaskCompleteSuspendStart	= profilerCallbackWaitTaskCompleteSuspendStart;
+		config.profilerCallbacks.waitForTaskCompleteSuspendStop		= profilerCallbackWaitTaskCompleteSuspendStop;
+
+		config.customAllocator.alloc	= rprofAllocFunc;
+		config.customAllocator.free		= rprofFreeFunc;
+		config.customAllocator.userData = 0;
+
+		s_taskNumIoThreads = s_taskConfig.m_numIoThreads;
+		if (s_taskNumIoThreads < 1)
+			s_taskNumIoThreads = 1;
+		if (s_taskNumIoThreads > RAPP_TASK_MAX_IO_THREADS)
+			s_taskNumIoThreads = RAPP_TASK_MAX_IO_THREADS;
+
+		config.numExternalTaskThreads	= 4 + s_taskNumIoThreads;	// main, app, timer, file completion and I/O threads
+
+		uint32_t numHardwareThreads = enki::GetNumHardwareThreads();
+		if (s_taskConfig.m_numWorkers)
+			config.numTaskThreadsToCreate = s_taskConfig.m_numWorkers;
+		else
+		if (s_taskConfig.m_numReservedCores)
+			config.numTaskThreadsToCreate = numHardwareThreads > s_taskConfig.m_numReservedCores ? numHardwareThreads - s_taskConfig.m_numReservedCores : 1;
+
+		// without explicit mask workers stay off the reserved cores
+		uint64_t affinityMask = s_taskConfig.m_affinityMask;
+		if (!affinityMask && s_taskConfig.m_numReservedCores)
+		{
+			for (uint32_t i=s_taskConfig.m_numReservedCores; i<numHardwareThreads && i<64; ++i)
+				affinityMask |= 1ULL << i;
+		}
+
+		s_taskNumWorkerCpus = 0;
+		for (uint32_t i=0; i<64; ++i)
+			if (affinityMask & (1ULL << i))
+				s_taskWorkerCpus[s_taskNumWorkerCpus++] = i;
+
+		s_taskFirstWorker = config.numExternalTaskThreads + 1;
+
+		s_taskFirstIoThread = enki::TaskScheduler::GetNumFirstExternalTaskThread() + 4;
+
+		taskPoolInit();
+		g_TS.Initialize(config);
+		s_taskRunning.store(true);
+
+		// external threads mostly block or wait for pinned work, partitioning only counts on workers
+		s_taskNumCompute = g_TS.GetNumTaskThreads() - config.numExternalTaskThreads;
+
+		s_taskIoRunning.store(true);
+		for (uint32_t i=0; i<s_taskNumIoThreads; ++i)
+		{
+			s_taskIoPending[i].store(0);
+			s_taskIoThreads[i].start(taskIoThreadFunc, (void*)(uintptr_t)(s_taskFirstIoThread + i), 0, "Task I/O");
+		}
+	}
+
+	/// 
+	void taskShutdown()
+	{
+		s_taskRunning.store(false);
+		while (s_taskPinnedRunners.load())
+			std::this_thread::yield();
+
+		s_taskIoRunning.store(false, std::memory_order_release);
+		TaskIoWake wake[RAPP_TASK_MAX_IO_THREADS];
+		for (uint32_t i=0; i<s_taskNumIoThreads; ++i)
+		{
+			wake[i].threadNum = s_taskFirstIoThread + i;
+			g_TS.AddPinnedTask(&wake[i]);
+		}
+		for (uint32_t i=0; i<s_taskNumIoThreads; ++i)
+			s_taskIoThreads[i].stop();
+
+		g_TS.WaitforAllAndShutdown();
+		taskPoolShutdown();
+	}
+
+	/// 
+	void taskRunPinned(uint32_t _thread)
+	{
+		s_taskPinnedRunners.fetch_add(1);
+		if (s_taskRunning.load())
+		{
+			if (!s_taskThreadRegistered)
+				s_taskThreadRegistered = g_TS.RegisterExternalTaskThread(taskThreadNum(_thread));
+
+			if (s_taskThreadRegistered)
+				g_TS.RunPinnedTasks();
+		}
+		s_taskPinnedRunners.fetch_sub(1);
+	}
+
+	/// 
+	bool taskRegisterThread(uint32_t _thread)
+	{
+		return g_TS.RegisterExternalTaskThread(taskThreadNum(_thread));
+	}
+
+	/// 
+	void taskUnregisterThread()
+	{
+		g_TS.DeRegisterExternalTaskThread();
+	}
+
+	/// 
+	void taskSetMainThreadWake(ThreadFn _fn, void* _userData)
+	{
+		s_mainThreadWakeFn			= _fn;
+		s_mainThreadWakeUserData	= _userData;
+	}
+
+	/// 
+	void taskSetAppThreadWake(ThreadFn _fn, void* _userData)
+	{
+		s_appThreadWakeFn			= _fn;
+		s_appThreadWakeUserData		= _userData;
+	}
+
+	/// 
+	TaskHandle taskCreate(TaskFn _func, void* _userData, bool _deleteOnFinish, const char* _name)
+	{
+		return taskCreateGroup(_func, _userData, 0, 1, _deleteOnFinish, _name);
+	}
+
+	/// 
+	TaskHandle taskCreateGroup(TaskFn _func, void* _userData, uint32_t _dataStride, uint32_t _numTasks, bool _deleteOnFinish, const char* _name)
+	{
+		Task* j = taskPoolAcquire();
+		if (!j)
+			return { UINT32_MAX };
+
+		j->m_SetSize	= _numTasks;
+		j->m_MinRange	= 1;
+		j->m_function	= _func;
+		j->m_functionEx	= 0;
+		j->m_userData	= _userData;
+		j->m_stride		= _dataStride;
+		j->m_start		= 0;
+		j->m_end		= _numTasks;
+		j->m_grain		= 0;
+		j->m_pinnedThread	= UINT32_MAX;
+		j->m_name			= _name ? _name : "Task";
+
+		taskPrepare(j, _deleteOnFinish);
+
+		return taskPoolHandle(j);
+	}
+
+	/// 
+	TaskHandle taskCreateDeferred(TaskFn _func, void* _userData, const char* _name)
+	{
+		TaskHandle handle = taskCreate(_func, _userData, true, _name);
+
+		Task* j = taskPoolGet(handle);
+		if (j)
+		{
+			j->m_deferred			= true;
+			j->m_control.m_internal	= true;
+			j->m_deferredDone.arm();
+		}
+
+		return handle;
+	}
+
+	/// 
+	void taskSetInternal(TaskHandle _task)
+	{
+		Task* j = taskPoolGet(_task);
+		if (j)
+			j->m_control.m_internal = true;
+	}
+
+	/// 
+	TaskHandle taskCreatePinned(ThreadFn _func, void* _userData, uint32_t _thread, bool _deleteOnFinish, const char* _name)
+	{
+		Task* j = taskPoolAcquire();
+		if (!j)
+			return { UINT32_MAX };
+
+		j->m_pinnedThread			= _thread;
+		j->m_pinned.threadNum		= taskThreadNum(_thread);
+		j->m_pinned.m_function		= _func;
+		j->m_pinned.m_userData		= _userData;
+		j->m_pinned.m_name			= _name ? _name : "Pinned task";
+
+		taskPrepare(j, _deleteOnFinish);
+
+		return taskPoolHandle(j);
+	}
+
+	/// 
+	TaskHandle taskCreateParallelFor(TaskFn _func, void* _data, uint32_t _dataStride, uint32_t _count, uint32_t _minGrain, bool _deleteOnFinish, const char* _name)
+	{
+		TaskHandle handle = taskCreateGroup(_func, _data, _dataStride, _count, _deleteOnFinish, _name);
+
+		Task* j = taskPoolGet(handle);
+		if (j)
+		{
+			j->m_grain		= taskGrainFind((const void*)_func);
+			j->m_MinRange	= taskGrainSize(j->m_grain, _count, _minGrain);
+		}
+
+		return handle;
+	}
+
+	/// 
+	TaskHandle taskCreate(TaskFnEx _func, void* _userData, bool _deleteOnFinish, const char* _name)
+	{
+		return taskCreateGroup(_func, _userData, 0, 1, _deleteOnFinish, _name);
+	}
+
+	/// 
+	TaskHandle taskCreateGroup(TaskFnEx _func, void* _userData, uint32_t _dataStride, uint32_t _numTasks, bool _deleteOnFinish, const char* _name)
+	{
+		TaskHandle handle = taskCreateGroup((TaskFn)0, _userData, _dataStride, _numTasks, _deleteOnFinish, _name);
+
+		Task* j = taskPoolGet(handle);
+		if (j)
+			j->m_functionEx = _func;
+
+		return handle;
+	}
+
+	/// 
+	TaskHandle taskCreateParallelFor(TaskFnEx _func, void* _data, uint32_t _dataStride, uint32_t _count, uint32_t _minGrain, bool _deleteOnFinish, const char* _name)
+	{
+		TaskHandle handle = taskCreateGroup(_func, _data, _dataStride, _count, _deleteOnFinish, _name);
+
+		Task* j = taskPoolGet(handle);
+		if (j)
+		{
+			j->m_grain		= taskGrainFind((const void*)_func);
+			j->m_MinRange	= taskGrainSize(j->m_grain, _count, _minGrain);
+		}
+
+		return handle;
+	}
+
+	/// 
+	uint32_t taskGetNumWorkers()
+	{
+		return g_TS.GetNumTaskThreads();
+	}
+
+	/// 
+	void taskDestroy(TaskHandle _task)
+	{
+		Task* j = taskPoolGet(_task);
+		if (!j)
+			return;
+
+		// batch launcher may not have submitted it yet
+		Task* launcher = taskPoolGet(j->m_launcher);
+		if (launcher)
+		{
+			g_TS.WaitforTask(launcher->completable());
+			j = taskPoolGet(_task);
+			if (!j)
+				return;
+		}
+
+		// completion action releases the slot of a launched delete on finish task
+		RTM_ASSERT(!(j->m_launched && j->m_deleteOnFinish), "Destroying a task that is deleted on finish!");
+		if (j->m_launched && j->m_deleteOnFinish)
+			return;
+
+		if (!j->completable()->GetIsComplete())
+			g_TS.WaitforTask(j->completable());
+
+		// completion action may still be launching continuations
+		if (j->m_launched)
+			while (!j->m_finished.load(std::memory_order_acquire))
+				std::this_thread::yield();
+
+		taskPoolRelease(j);
+	}
+
+	/// 
+	void taskRun(TaskHandle _task)
+	{
+		Task* j = taskPoolGet(_task);
+		RTM_ASSERT(j, "Running a stale task handle!");
+		if (!j)
+			return;
+
+		uint32_t threadNum = g_TS.GetThreadNum();
+		TaskThreadCounters& counters = taskCounters(threadNum);
+		counters.m_numSubmitted.fetch_add(1, std::memory_order_relaxed);
+		s_taskSubmitCount.fetch_add(1, std::memory_order_relaxed);
+
+		j->m_launched = true;
+
+		if ((j->m_pinnedThread == UINT32_MAX) && s_taskSerial.load(std::memory_order_relaxed))
+		{
+			taskRunInline(j, threadNum);
+			return;
+		}
+
+		if (s_taskRecordTimings.load(std::memory_order_relaxed))
+			j->m_submitClock = rtm::cpuClock();
+
+		if (j->m_pinnedThread == UINT32_MAX)
+		{
+			bool		prevSubmitting	= s_taskSubmitting;
+			uint32_t	prevInline		= s_taskInlinePartitions;
+			s_taskSubmitting		= true;
+			s_taskInlinePartitions	= 0;
+
+			j->m_submitThread = threadNum;
+			g_TS.AddTaskSetToPipe(j);
+
+			if (s_taskInlinePartitions)
+				counters.m_numPipeFull.fetch_add(1, std::memory_order_relaxed);
+
+			s_taskSubmitting		= prevSubmitting;
+			s_taskInlinePartitions	= prevInline;
+			return;
+		}
+
+		// read before adding, task may complete and be released right after
+		uint32_t thread = j->m_pinnedThread;
+		if (thread == RAPP_TASK_THREAD_IO)
+			j->m_pinned.threadNum = taskIoThreadPick();
+		g_TS.AddPinnedTask(&j->m_pinned);
+		taskWakeThread(thread);
+	}
+
+	/// 
+	void taskWait(TaskHandle _task)
+	{
+		Task* j = taskPoolGet(_task);
+
+		// deferred tasks count as complete until launched, their signal completes with the task instead
+		if (j && j->m_deferred)
+		{
+			g_TS.WaitforTask(&j->m_deferredDone);
+			return;
+		}
+
+		// batch launcher has to submit the task before its completable can be waited on
+		Task* launcher = j ? taskPoolGet(j->m_launcher) : 0;
+		if (launcher)
+		{
+			g_TS.WaitforTask(launcher->completable());
+			j = taskPoolGet(_task);
+		}
+
+		if (j)
+			g_TS.WaitforTask(j->completable());
+	}
+
+	/// 
+	void taskRunBlocking(ThreadFn _func, void* _userData)
+	{
+		// already on I/O pool, handing off would only add latency
+		if (taskIsIoThread(g_TS.GetThreadNum()))
+		{
+			_func(_userData);
+			return;
+		}
+
+		TaskHandle task = taskCreatePinned(_func, _userData, RAPP_TASK_THREAD_IO, false, "Blocking call");
+		if (!isValid(task))
+		{
+			_func(_userData);
+			return;
+		}
+
+		taskRun(task);
+		taskWait(task);
+		taskDestroy(task);
+	}
+
+	/// Copy of batch handles owned by the launcher task, freed by the partition submitting the last one.
+	struct TaskBatch
+	{
+		std::atomic<uint32_t>	m_remaining;
+		TaskHandle				m_tasks[1];
+	};
+
+	/// Launcher partition, submits its share of the batch and wakes main and app threads once.
+	static void taskBatchLaunch(void* _userData, uint32_t _start, uint32_t _end)
+	{
+		TaskBatch* batch = (TaskBatch*)_userData;
+
+		bool		prevBatching	= s_taskWakeBatching;
+		uint32_t	prevMask		= s_taskWakeMask;
+		s_taskWakeBatching	= true;
+		s_taskWakeMask		= 0;
+
+		for (uint32_t i=_start; i<_end; ++i)
+			taskRun(batch->m_tasks[i]);
+
+		uint32_t mask		= s_taskWakeMask;
+		s_taskWakeBatching	= prevBatching;
+		s_taskWakeMask		= prevMask;
+
+		if (mask & 1)
+			taskWakeThread(RAPP_TASK_THREAD_MAIN);
+		if (mask & 2)
+			taskWakeThread(RAPP_TASK_THREAD_APP);
+
+		if (batch->m_remaining.fetch_sub(_end - _start, std::memory_order_acq_rel) == _end - _start)
+			rtm_free(batch);
+	}
+
+	/// 
+	void taskRunBatch(const TaskHandle* _tasks, uint32_t _count)
+	{
+		TaskBatch* batch = 0;
+		TaskHandle launcher = { UINT32_MAX };
+		if ((_count >= RAPP_TASK_BATCH_MIN) && !s_taskSerial.load(std::memory_order_relaxed))
+		{
+			batch = (TaskBatch*)rtm_alloc(sizeof(TaskBatch) + sizeof(TaskHandle) * (_count - 1));
+			if (batch)
+				launcher = taskCreateGroup(taskBatchLaunch, 0, 0, _count, true, "Task batch");
+		}
+
+		// small batch, serial mode or out of memory, submitted directly by the caller
+		Task* l = taskPoolGet(launcher);
+		if (!l)
+		{
+			if (batch)
+				rtm_free(batch);
+
+			for (uint32_t i=0; i<_count; ++i)
+				taskRun(_tasks[i]);
+			return;
+		}
+
+		batch->m_remaining.store(_count, std::memory_order_relaxed);
+		memcpy(batch->m_tasks, _tasks, sizeof(TaskHandle) * _count);
+
+		// waits on batch tasks go through the launcher until it has submitted them
+		for (uint32_t i=0; i<_count; ++i)
+		{
+			Task* j = taskPoolGet(_tasks[i]);
+			if (j)
+				j->m_launcher = launcher;
+		}
+
+		l->m_userData			= batch;
+		l->m_MinRange			= RAPP_TASK_BATCH_GRAIN;
+		l->m_control.m_internal	= true;
+
+		// single submission, the caller doesn't wait for partitions to launch the tasks
+		taskRun(launcher);
+	}
+
+	static inline bool taskIsDone(TaskHandle _task)
+	{
+		Task* j = taskPoolGet(_task);
+		if (j && j->m_deferred && !j->m_launched.load(std::memory_order_acquire))
+			return false;
+
+		// not submitted by its batch launcher yet
+		Task* launcher = j && !j->m_launched.load(std::memory_order_acquire) ? taskPoolGet(j->m_launcher) : 0;
+		if (launcher && !launcher->completable()->GetIsComplete())
+			return false;
+
+		// re-read, task may have been submitted, finished and released meanwhile
+		j = taskPoolGet(_task);
+		return !j || j->completable()->GetIsComplete();
+	}
+
+	/// 
+	void taskWaitAll(const TaskHandle* _tasks, uint32_t _count)
+	{
+		// waiting executes other tasks, by the time one task is done most of the others are as well
+		for (uint32_t i=0; i<_count; ++i)
+			if (!taskIsDone(_tasks[i]))
+				taskWait(_tasks[i]);
+	}
+
+	/// 
+	uint32_t taskWaitAny(const TaskHandle* _tasks, uint32_t _count)
+	{
+		if (!_count)
+			return UINT32_MAX;
+
+		for (uint32_t i=0; i<_count; ++i)
+			if (taskIsDone(_tasks[i]))
+				return i;
+
+		TaskWaitSink sink;
+		sink.m_tasks	= _tasks;
+		sink.m_count	= _count;
+		sink.m_signal.arm();
+
+		{
+			rtm::ScopedMutexLocker lock(s_taskWaitLock);
+			sink.m_next		= s_taskWaitSinks;
+			s_taskWaitSinks	= &sink;
+			s_taskNumWaitSinks.fetch_add(1, std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		// completions are signalled from now on, check again for the ones that happened meanwhile
+		uint32_t done = UINT32_MAX;
+		while (done == UINT32_MAX)
+		{
+			for (uint32_t i=0; i<_count; ++i)
+				if (taskIsDone(_tasks[i]))
+				{
+					done = i;
+					break;
+				}
+
+			// executes other tasks while waiting, returns once any of the tasks has completed
+			if (done == UINT32_MAX)
+				g_TS.WaitforTask(&sink.m_signal);
+		}
+
+		{
+			rtm::ScopedMutexLocker lock(s_taskWaitLock);
+			TaskWaitSink** link = &s_taskWaitSinks;
+			while (*link != &sink)
+				link = &(*link)->m_next;
+			*link = sink.m_next;
+			s_taskNumWaitSinks.fetch_sub(1, std::memory_order_relaxed);
+
+			// signal has to complete before it goes out of scope
+			sink.m_signal.signal(g_TS.GetThreadNum());
+		}
+
+		return done;
+	}
+
+	/// 
+	uint32_t taskStatus(TaskHandle _task)
+	{
+		Task* j = taskPoolGet(_task);
+		if (!j)
+			return RAPP_TASK_STATUS_COMPLETE;
+
+		if (!j->m_launched.load(std::memory_order_acquire))
+			return RAPP_TASK_STATUS_PENDING;
+
+		uint32_t status = j->m_control.m_status.load(std::memory_order_acquire);
+		if ((status == RAPP_TASK_STATUS_COMPLETE) || (status == RAPP_TASK_STATUS_CANCELLED))
+			return status;
+
+		// partitions are done, completion action has not latched the status yet
+		if (j->completable()->GetIsComplete())
+			return j->m_control.m_cancelled.load(std::memory_order_relaxed) ? RAPP_TASK_STATUS_CANCELLED : RAPP_TASK_STATUS_COMPLETE;
+
+		return status;
+	}
+
+	/// 
+	void taskCancel(TaskHandle _task)
+	{
+		Task* j = taskPoolGet(_task);
+		if (j && !j->m_control.m_internal && !j->completable()->GetIsComplete())
+			j->m_control.m_cancelled.store(true, std::memory_order_relaxed);
+	}
+
+	/// 
+	void taskCancelAll()
+	{
+		s_taskCancelEpoch.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/// 
+	void taskSetDeadline(TaskHandle _task, float _seconds)
+	{
+		Task* j = taskPoolGet(_task);
+		if (!j)
+			return;
+
+		uint64_t deadline = rtm::cpuClock() + (uint64_t)((double)_seconds * (double)rtm::cpuFrequency());
+		j->m_control.m_deadline.store(deadline ? deadline : 1, std::memory_order_relaxed);
+	}
+
+	/// 
+	bool taskIsCancelled()
+	{
+		return s_taskCurrent && s_taskCurrent->isCancelled();
+	}
+
+	/// Links continuation to parent, launches it right away if parent already completed.
+	static void taskAttach(TaskHandle _parent, Task* _continuation)
+	{
+		Task* parent = taskPoolGet(_parent);
+		if (parent)
+		{
+			uint64_t head = parent->m_continuations.load(std::memory_order_acquire);
+			while (((head >> 32) == _parent.idx) && ((uint32_t)head != RAPP_TASK_CONTINUATION_CLOSED))
+			{
+				_continuation->m_nextContinuation = (uint32_t)head;
+				if (parent->m_continuations.compare_exchange_weak(head, (head & 0xffffffff00000000ULL) | _continuation->m_index, std::memory_order_acq_rel, std::memory_order_acquire))
+					return;
+			}
+		}
+
+		// stale handle or closed list, parent is complete
+		taskLaunch(_continuation);
+	}
+
+	/// 
+	TaskHandle taskThen(TaskHandle _parent, TaskFn _func, void* _userData, bool _deleteOnFinish, const char* _name)
+	{
+		TaskHandle handle = taskCreate(_func, _userData, _deleteOnFinish, _name ? _name : "Continuation");
+
+		Task* j = taskPoolGet(handle);
+		if (j)
+			taskAttach(_parent, j);
+
+		return handle;
+	}
+
+	/// 
+	bool taskThenOnAppThread(TaskHandle _parent, ThreadFn _func, void* _userData)
+	{
+		Task* j = taskPoolAcquire();
+		if (!j)
+			return false;
+
+		j->m_pinnedThread			= UINT32_MAX;
+		j->m_pinned.m_function		= _func;
+		j->m_pinned.m_userData		= _userData;
+
+		taskPrepare(j, true);
+		j->m_appCallback = true;
+
+		taskAttach(_parent, j);
+		return true;
+	}
+
+	/// 
+	bool taskHasAppCallbacks()
+	{
+		return s_taskAppCallbacks.load(std::memory_order_relaxed) != RAPP_TASK_CONTINUATION_NONE;
+	}
+
+	/// 
+	void taskRunAppCallbacks()
+	{
+		uint32_t head = s_taskAppCallbacks.exchange(RAPP_TASK_CONTINUATION_NONE, std::memory_order_acquire);
+
+		// list is LIFO, reverse to call back in completion order
+		uint32_t prev = RAPP_TASK_CONTINUATION_NONE;
+		while (head != RAPP_TASK_CONTINUATION_NONE)
+		{
+			Task* j = taskPoolAt(head);
+			uint32_t next = j->m_nextContinuation;
+			j->m_nextContinuation = prev;
+			prev = head;
+			head = next;
+		}
+
+		while (prev != RAPP_TASK_CONTINUATION_NONE)
+		{
+			Task* j = taskPoolAt(prev);
+			prev = j->m_nextContinuation;
+
+			j->m_pinned.m_function(j->m_pinned.m_userData);
+			taskPoolRelease(j);
+		}
+	}
+
+	/// 
+	void taskGetPoolStats(TaskPoolStats& _stats)
+	{
+		_stats.m_capacity		= s_taskPool.m_capacity.load(std::memory_order_relaxed);
+		_stats.m_numLive		= s_taskPool.m_numLive.load(std::memory_order_relaxed);
+		_stats.m_numAllocations	= s_taskPool.m_numAllocations.load(std::memory_order_relaxed);
+	}
+
+	/// 
+	void taskConfigParse(TaskConfig& _config, int32_t _argc, const char* const* _argv)
+	{
+		for (int32_t i=1; i<_argc; ++i)
+		{
+			const char* arg = _argv[i];
+
+			if (strncmp(arg, "--task-workers=", 15) == 0)
+				_config.m_numWorkers = (uint32_t)strtoul(arg + 15, 0, 10);
+			else
+			if (strncmp(arg, "--task-reserve=", 15) == 0)
+				_config.m_numReservedCores = (uint32_t)strtoul(arg + 15, 0, 10);
+			else
+			if (strncmp(arg, "--task-affinity=", 16) == 0)
+				_config.m_affinityMask = (uint64_t)strtoull(arg + 16, 0, 0);
+			else
+			if (strncmp(arg, "--task-wait=", 12) == 0)
+			{
+				if (rtm::striCmp(arg + 12, "spin") == 0)
+					_config.m_waitPolicy = RAPP_TASK_WAIT_SPIN;
+				else
+				if (rtm::striCmp(arg + 12, "sleep") == 0)
+					_config.m_waitPolicy = RAPP_TASK_WAIT_SLEEP;
+			}
+			else
+			if (strncmp(arg, "--task-io=", 10) == 0)
+				_config.m_numIoThreads = (uint32_t)strtoul(arg + 10, 0, 10);
+			else
+			if (strcmp(arg, "--task-serial") == 0)
+				_config.m_serial = true;
+			else
+			if (strcmp(arg, "--task-timings") == 0)
+				_config.m_recordTimings = true;
+		}
+	}
+
+	/// 
+	void taskGetConfig(TaskConfig& _config)
+	{
+		_config = s_taskConfig;
+		_config.m_serial		= s_taskSerial.load(std::memory_order_relaxed);
+		_config.m_recordTimings	= s_taskRecordTimings.load(std::memory_order_relaxed);
+	}
+
+	/// 
+	void taskSetSerial(bool _serial)
+	{
+		s_taskSerial.store(_serial, std::memory_order_relaxed);
+	}
+
+	/// 
+	void taskSetRecordTimings(bool _record)
+	{
+		s_taskRecordTimings.store(_record, std::memory_order_relaxed);
+	}
+
+	/// 
+	uint32_t taskGetTimings(TaskTiming* _timings, uint32_t _maxTimings)
+	{
+		const double toMs = 1000.0 / (double)rtm::cpuFrequency();
+
+		uint32_t count = 0;
+		for (uint32_t i=0; (i<RAPP_TASK_TIMING_TABLE_SIZE) && (count<_maxTimings); ++i)
+		{
+			TaskTimingEntry& entry = s_timingTable[i];
+			uintptr_t name = entry.m_name.load(std::memory_order_acquire);
+			if (!name)
+				continue;
+
+			TaskTiming& timing = _timings[count++];
+			timing.m_name			= (const char*)name;
+			timing.m_numSerial		= entry.m_numSerial.load(std::memory_order_relaxed);
+			timing.m_timeSerial		= (float)(entry.m_serialTicks.load(std::memory_order_relaxed) * toMs);
+			timing.m_numParallel	= entry.m_numParallel.load(std::memory_order_relaxed);
+			timing.m_timeParallel	= (float)(entry.m_parallelTicks.load(std::memory_order_relaxed) * toMs);
+		}
+		return count;
+	}
+
+	/// 
+	void taskResetTimings()
+	{
+		// names stay in place, entries can be updated concurrently
+		for (uint32_t i=0; i<RAPP_TASK_TIMING_TABLE_SIZE; ++i)
+		{
+			TaskTimingEntry& entry = s_timingTable[i];
+			entry.m_numSerial.store(0, std::memory_order_relaxed);
+			entry.m_serialTicks.store(0, std::memory_order_relaxed);
+			entry.m_numParallel.store(0, std::memory_order_relaxed);
+			entry.m_parallelTicks.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	/// 
+	void taskGetStats(TaskStats& _stats)
+	{
+		const double toMs = 1000.0 / (double)rtm::cpuFrequency();
+
+		uint32_t numThreads = g_TS.GetNumTaskThreads();
+		_stats.m_numThreads		= numThreads < RAPP_TASK_MAX_THREADS ? numThreads : RAPP_TASK_MAX_THREADS;
+		_stats.m_numSubmitted	= 0;
+		_stats.m_numPipeFull	= 0;
+
+		for (uint32_t i=0; i<_stats.m_numThreads; ++i)
+		{
+			TaskThreadCounters& counters	= s_taskCounters[i];
+			TaskThreadStats& stats			= _stats.m_threads[i];
+
+			stats.m_numExecuted		= counters.m_numExecuted.load(std::memory_order_relaxed);
+			stats.m_numRemote		= counters.m_numRemote.load(std::memory_order_relaxed);
+			stats.m_numSubmitted	= counters.m_numSubmitted.load(std::memory_order_relaxed);
+			stats.m_numPipeFull		= counters.m_numPipeFull.load(std::memory_order_relaxed);
+			stats.m_timeBusy		= (float)(counters.m_busyTicks.load(std::memory_order_relaxed) * toMs);
+			stats.m_timeWaiting		= (float)(counters.m_waitTicks.load(std::memory_order_relaxed) * toMs);
+			stats.m_timeSuspended	= (float)(counters.m_suspendTicks.load(std::memory_order_relaxed) * toMs);
+
+			_stats.m_numSubmitted	+= stats.m_numSubmitted;
+			_stats.m_numPipeFull	+= stats.m_numPipeFull;
+		}
+	}
+
+	/// 
+	TaskGraphHandle taskGraphCreate()
+	{
+		TaskGraph* graph = rtm_new<TaskGraph>();
+		return { (uintptr_t)graph };
+	}
+
+	/// 
+	void taskGraphDestroy(TaskGraphHandle _graph)
+	{
+		TaskGraph* graph = (TaskGraph*)_graph.idx;
+		taskGraphSync(graph);
+		rtm_delete<TaskGraph>(graph);
+	}
+
+	/// 
+	uint32_t taskGraphAddNode(TaskGraphHandle _graph, TaskFn _func, void* _userData, uint32_t _numTasks, const char* _name)
+	{
+		TaskGraph* graph = (TaskGraph*)_graph.idx;
+		RTM_ASSERT(graph->m_numNodes < RAPP_TASK_GRAPH_MAX_NODES, "Too many task graph nodes!");
+		if (graph->m_numNodes == RAPP_TASK_GRAPH_MAX_NODES)
+			return UINT32_MAX;
+
+		taskGraphSync(graph);
+
+		TaskGraphNode& node = graph->m_nodes[graph->m_numNodes];
+		node.m_SetSize	= _numTasks;
+		node.m_MinRange	= 1;
+		node.m_function	= _func;
+		node.m_userData	= _userData;
+		node.m_name		= _name ? _name : "Task graph node";
+
+		graph->m_dirty = true;
+		return graph->m_numNodes++;
+	}
+
+	/// 
+	void taskGraphAddEdge(TaskGraphHandle _graph, uint32_t _from, uint32_t _to)
+	{
+		TaskGraph* graph = (TaskGraph*)_graph.idx;
+		RTM_ASSERT(_from < graph->m_numNodes && _to < graph->m_numNodes && _from != _to, "Invalid task graph edge!");
+		RTM_ASSERT(graph->m_numEdges < RAPP_TASK_GRAPH_MAX_EDGES, "Too many task graph edges!");
+		if (graph->m_numEdges == RAPP_TASK_GRAPH_MAX_EDGES)
+			return;
+
+		taskGraphSync(graph);
+
+		TaskGraph::Edge& edge = graph->m_edges[graph->m_numEdges++];
+		edge.m_from	= (uint16_t)_from;
+		edge.m_to	= (uint16_t)_to;
+
+		graph->m_dirty = true;
+	}
+
+	/// 
+	void taskGraphRun(TaskGraphHandle _graph)
+	{
+		TaskGraph* graph = (TaskGraph*)_graph.idx;
+		if (!graph->m_numNodes)
+			return;
+
+		// previous launch has to finish before the graph can be re-launched
+		taskGraphSync(graph);
+
+		if (graph->m_dirty)
+			taskGraphBuild(graph);
+
+		graph->m_launched = true;
+		s_taskSubmitCount.fetch_add(1, std::memory_order_relaxed);
+
+		if (s_taskSerial.load(std::memory_order_relaxed))
+		{
+			uint32_t threadNum = g_TS.GetThreadNum();
+			for (uint32_t i=0; i<graph->m_numNodes; ++i)
+			{
+				TaskGraphNode& node = graph->m_nodes[graph->m_order[i]];
+
+				enki::TaskSetPartition range;
+				range.start	= 0;
+				range.end	= node.m_SetSize;
+
+				uint64_t startClock = rtm::cpuClock();
+				node.ExecuteRange(range, threadNum);
+				if (s_taskRecordTimings.load(std::memory_order_relaxed))
+					taskTimingAdd(node.m_name, rtm::cpuClock() - startClock, true);
+			}
+			return;
+		}
+
+		g_TS.AddTaskSetToPipe(&graph->m_root);
+	}
+
+	/// 
+	void taskGraphWait(TaskGraphHandle _graph)
+	{
+		TaskGraph* graph = (TaskGraph*)_graph.idx;
+		taskGraphSync(graph);
+	}
+
+	/// 
+	uint32_t taskGraphStatus(TaskGraphHandle _graph)
+	{
+		TaskGraph* graph = (TaskGraph*)_graph.idx;
+		if (!graph->m_launched)
+			return RAPP_TASK_STATUS_PENDING;
+		return graph->m_sink.GetIsComplete() ? RAPP_TASK_STATUS_COMPLETE : RAPP_TASK_STATUS_RUNNING;
+	}
+
+	typedef void(*ParallelBlockFn)(void* _context, uint32_t _block, uint32_t _threadNum);
+
+	/// Task set calling a function for each block of a parallel algorithm, lives on the caller stack.
+	class ParallelBlocks : public enki::ITaskSet
+	{
+	public:
+		ParallelBlockFn	m_function;
+		void*			m_context;
+
+		void ExecuteRange(enki::TaskSetPartition _range, uint32_t _threadnum) override
+		{
+			uint64_t startClock = rtm::cpuClock();
+			for (uint32_t i=_range.start; i<_range.end; ++i)
+				m_function(m_context, i, _threadnum);
+			taskCountExecuted(_threadnum, rtm::cpuClock() - startClock, false);
+		}
+	};
+
+	static void parallelRun(uint32_t _numBlocks, ParallelBlockFn _func, void* _context)
+	{
+		if ((_numBlocks == 1) || s_taskSerial.load(std::memory_order_relaxed))
+		{
+			uint32_t threadNum = g_TS.GetThreadNum();
+			for (uint32_t i=0; i<_numBlocks; ++i)
+				_func(_context, i, threadNum);
+			return;
+		}
+
+		ParallelBlocks blocks;
+		blocks.m_SetSize	= _numBlocks;
+		blocks.m_MinRange	= 1;
+		blocks.m_function	= _func;
+		blocks.m_context	= _context;
+
+		s_taskSubmitCount.fetch_add(1, std::memory_order_relaxed);
+		g_TS.AddTaskSetToPipe(&blocks);
+		g_TS.WaitforTask(&blocks);
+	}
+
+	static uint32_t parallelNumBlocks(uint32_t _count)
+	{
+		uint32_t maxBlocks = s_taskNumCompute * RAPP_PARALLEL_BLOCKS_PER_THREAD;
+		uint32_t numBlocks = (_count + RAPP_PARALLEL_MIN_BLOCK - 1) / RAPP_PARALLEL_MIN_BLOCK;
+		if (numBlocks > maxBlocks)
+			numBlocks = maxBlocks;
+		return numBlocks ? numBlocks : 1;
+	}
+
+	static inline void parallelBlockRange(uint32_t _count, uint32_t _numBlocks, uint32_t _block, uint32_t& _start, uint32_t& _end)
+	{
+		_start	= (uint32_t)((uint64_t)_count * _block / _numBlocks);
+		_end	= (uint32_t)((uint64_t)_count * (_block + 1) / _numBlocks);
+	}
+
+	static inline void parallelSwap(uint8_t* _a, uint8_t* _b, uint32_t _stride)
+	{
+		for (uint32_t i=0; i<_stride; ++i)
+		{
+			uint8_t temp = _a[i];
+			_a[i] = _b[i];
+			_b[i] = temp;
+		}
+	}
+
+	struct ParallelReduce
+	{
+		const void*	m_data;
+		uint32_t	m_count;
+		uint32_t	m_numBlocks;
+		uint8_t*	m_partials;			// one per thread, cache line aligned
+		uint32_t	m_partialStride;
+		ReduceFn	m_reduce;
+		void*		m_userData;
+	};
+
+	static void parallelReduceBlock(void* _context, uint32_t _block, uint32_t _threadNum)
+	{
+		ParallelReduce* ctx = (ParallelReduce*)_context;
+
+		uint32_t start, end;
+		parallelBlockRange(ctx->m_count, ctx->m_numBlocks, _block, start, end);
+		ctx->m_reduce(ctx->m_partials + _threadNum * ctx->m_partialStride, ctx->m_data, start, end, ctx->m_userData);
+	}
+
+	/// 
+	void parallelReduce(const void* _data, uint32_t _count, void* _result, uint32_t _resultSize, ReduceFn _reduce, CombineFn _combine, void* _userData)
+	{
+		if (!_count)
+			return;
+
+		uint32_t numBlocks = parallelNumBlocks(_count);
+		if (numBlocks == 1)
+		{
+			_reduce(_result, _data, 0, _count, _userData);
+			return;
+		}
+
+		uint32_t numThreads		= g_TS.GetNumTaskThreads();	// partials are indexed by thread number, not by block
+		uint32_t partialStride	= (_resultSize + 63) & ~63;
+
+		ParallelReduce ctx;
+		ctx.m_data			= _data;
+		ctx.m_count			= _count;
+		ctx.m_numBlocks		= numBlocks;
+		ctx.m_partials		= (uint8_t*)frameAlloc(partialStride * numThreads, 64);
+		ctx.m_partialStride	= partialStride;
+		ctx.m_reduce		= _reduce;
+		ctx.m_userData		= _userData;
+
+		if (!ctx.m_partials)
+		{
+			_reduce(_result, _data, 0, _count, _userData);
+			return;
+		}
+
+		for (uint32_t i=0; i<numThreads; ++i)
+			memcpy(ctx.m_partials + i * partialStride, _result, _resultSize);
+
+		parallelRun(numBlocks, parallelReduceBlock, &ctx);
+
+		for (uint32_t i=0; i<numThreads; ++i)
+			_combine(_result, ctx.m_partials + i * partialStride, _userData);
+	}
+
+	struct ParallelScan
+	{
+		const uint8_t*	m_in;
+		uint8_t*		m_out;
+		uint32_t		m_stride;
+		uint32_t		m_count;
+		uint32_t		m_numBlocks;
+		uint8_t*		m_blockSums;	// block totals, then inclusive prefix of block totals
+		CombineFn		m_combine;
+		void*			m_userData;
+	};
+
+	static void parallelScanSumBlock(void* _context, uint32_t _block, uint32_t _threadNum)
+	{
+		RTM_UNUSED(_threadNum);
+		ParallelScan* ctx = (ParallelScan*)_context;
+
+		uint32_t start, end;
+		parallelBlockRange(ctx->m_count, ctx->m_numBlocks, _block, start, end);
+
+		uint8_t* sum = ctx->m_blockSums + _block * ctx->m_stride;
+		memcpy(sum, ctx->m_in + start * ctx->m_stride, ctx->m_stride);
+		for (uint32_t i=start+1; i<end; ++i)
+			ctx->m_combine(sum, ctx->m_in + i * ctx->m_stride, ctx->m_userData);
+	}
+
+	static void parallelScanBlock(void* _context, uint32_t _block, uint32_t _threadNum)
+	{
+		RTM_UNUSED(_threadNum);
+		ParallelScan* ctx = (ParallelScan*)_context;
+
+		uint32_t start, end;
+		parallelBlockRange(ctx->m_count, ctx->m_numBlocks, _block, start, end);
+
+		// combined in a temporary so input can be overwritten in place
+		uint8_t temp[RAPP_PARALLEL_MAX_STRIDE];
+		const uint8_t* prev = _block ? ctx->m_blockSums + (_block - 1) * ctx->m_stride : 0;
+		for (uint32_t i=start; i<end; ++i)
+		{
+			const uint8_t* in	= ctx->m_in  + i * ctx->m_stride;
+			uint8_t* out		= ctx->m_out + i * ctx->m_stride;
+
+			if (prev)
+			{
+				memcpy(temp, prev, ctx->m_stride);
+				ctx->m_combine(temp, in, ctx->m_userData);
+			}
+			else
+				memcpy(temp, in, ctx->m_stride);
+
+			memcpy(out, temp, ctx->m_stride);
+			prev = out;
+		}
+	}
+
+	/// 
+	void parallelInclusiveScan(const void* _in, void* _out, uint32_t _stride, uint32_t _count, CombineFn _combine, void* _userData)
+	{
+		RTM_ASSERT(_stride <= RAPP_PARALLEL_MAX_STRIDE, "Item size is larger than RAPP_PARALLEL_MAX_STRIDE!");
+		if (!_count || (_stride > RAPP_PARALLEL_MAX_STRIDE))
+			return;
+
+		ParallelScan ctx;
+		ctx.m_in			= (const uint8_t*)_in;
+		ctx.m_out			= (uint8_t*)_out;
+		ctx.m_stride		= _stride;
+		ctx.m_count			= _count;
+		ctx.m_numBlocks		= parallelNumBlocks(_count);
+		ctx.m_blockSums		= 0;
+		ctx.m_combine		= _combine;
+		ctx.m_userData		= _userData;
+
+		if (ctx.m_numBlocks > 1)
+			ctx.m_blockSums = (uint8_t*)frameAlloc(_stride * ctx.m_numBlocks);
+
+		if (!ctx.m_blockSums)
+		{
+			ctx.m_numBlocks = 1;
+			parallelScanBlock(&ctx, 0, 0);
+			return;
+		}
+
+		parallelRun(ctx.m_numBlocks, parallelScanSumBlock, &ctx);
+
+		uint8_t temp[RAPP_PARALLEL_MAX_STRIDE];
+		for (uint32_t i=1; i<ctx.m_numBlocks; ++i)
+		{
+			uint8_t* sum = ctx.m_blockSums + i * _stride;
+			memcpy(temp, sum - _stride, _stride);
+			_combine(temp, sum, _userData);
+			memcpy(sum, temp, _stride);
+		}
+
+		parallelRun(ctx.m_numBlocks, parallelScanBlock, &ctx);
+	}
+
+	template <typename T>
+	struct ParallelRadix
+	{
+		T*			m_srcKeys;
+		T*			m_dstKeys;
+		uint32_t*	m_srcValues;
+		uint32_t*	m_dstValues;
+		uint32_t	m_count;
+		uint32_t	m_numBlocks;
+		uint32_t	m_shift;
+		uint32_t*	m_histograms;	// 256 counters per block, turned into scatter offsets
+	};
+
+	template <typename T>
+	static void parallelRadixHistogramBlock(void* _context, uint32_t _block, uint32_t _threadNum)
+	{
+		RTM_UNUSED(_threadNum);
+		ParallelRadix<T>* ctx = (ParallelRadix<T>*)_context;
+
+		uint32_t start, end;
+		parallelBlockRange(ctx->m_count, ctx->m_numBlocks, _block, start, end);
+
+		uint32_t* histogram = ctx->m_histograms + _block * 256;
+		memset(histogram, 0, sizeof(uint32_t) * 256);
+		for (uint32_t i=start; i<end; ++i)
+			++histogram[(ctx->m_srcKeys[i] >> ctx->m_shift) & 0xff];
+	}
+
+	template <typename T>
+	static void parallelRadixScatterBlock(void* _context, uint32_t _block, uint32_t _threadNum)
+	{
+		RTM_UNUSED(_threadNum);
+		ParallelRadix<T>* ctx = (ParallelRadix<T>*)_context;
+
+		uint32_t start, end;
+		parallelBlockRange(ctx->m_count, ctx->m_numBlocks, _block, start, end);
+
+		uint32_t* offsets = ctx->m_histograms + _block * 256;
+		for (uint32_t i=start; i<end; ++i)
+		{
+			uint32_t dst = offsets[(ctx->m_srcKeys[i] >> ctx->m_shift) & 0xff]++;
+			ctx->m_dstKeys[dst] = ctx->m_srcKeys[i];
+			if (ctx->m_srcValues)
+				ctx->m_dstValues[dst] = ctx->m_srcValues[i];
+		}
+	}
+
+	/// Stable insertion sort that needs no scratch memory, used when scratch can't be allocated.
+	template <typename T>
+	static void parallelRadixSortSerial(T* _keys, uint32_t _count, uint32_t* _values)
+	{
+		for (uint32_t i=1; i<_count; ++i)
+		{
+			T key = _keys[i];
+			uint32_t value = _values ? _values[i] : 0;
+
+			uint32_t j = i;
+			for (; j && (key < _keys[j - 1]); --j)
+			{
+				_keys[j] = _keys[j - 1];
+				if (_values)
+					_values[j] = _values[j - 1];
+			}
+
+			_keys[j] = key;
+			if (_values)
+				_values[j] = value;
+		}
+	}
+
+	template <typename T>
+	static void parallelRadixSort(T* _keys, uint32_t _count, uint32_t* _values)
+	{
+		if (_count < 2)
+			return;
+
+		ParallelRadix<T> ctx;
+		ctx.m_numBlocks		= parallelNumBlocks(_count);
+		ctx.m_count			= _count;
+		ctx.m_srcKeys		= _keys;
+		ctx.m_dstKeys		= (T*)frameAlloc(sizeof(T) * _count);
+		ctx.m_srcValues		= _values;
+		ctx.m_dstValues		= _values ? (uint32_t*)frameAlloc(sizeof(uint32_t) * _count) : 0;
+		ctx.m_histograms	= (uint32_t*)frameAlloc(sizeof(uint32_t) * 256 * ctx.m_numBlocks);
+
+		if (!ctx.m_dstKeys || (_values && !ctx.m_dstValues) || !ctx.m_histograms)
+		{
+			parallelRadixSortSerial(_keys, _count, _values);
+			return;
+		}
+
+		for (ctx.m_shift=0; ctx.m_shift<sizeof(T)*8; ctx.m_shift+=8)
+		{
+			parallelRun(ctx.m_numBlocks, parallelRadixHistogramBlock<T>, &ctx);
+
+			// offsets are laid out digit major so each block scatters stably after preceding blocks
+			uint32_t offset = 0;
+			bool skipPass = false;
+			for (uint32_t digit=0; digit<256; ++digit)
+			{
+				uint32_t digitStart = offset;
+				for (uint32_t block=0; block<ctx.m_numBlocks; ++block)
+				{
+					uint32_t* counter = &ctx.m_histograms[block * 256 + digit];
+					uint32_t count = *counter;
+					*counter = offset;
+					offset += count;
+				}
+
+				if (offset - digitStart == _count)
+				{
+					skipPass = true;	// all keys share the digit, order is unchanged
+					break;
+				}
+			}
+
+			if (skipPass)
+				continue;
+
+			parallelRun(ctx.m_numBlocks, parallelRadixScatterBlock<T>, &ctx);
+
+			T* keys = ctx.m_srcKeys;
+			ctx.m_srcKeys = ctx.m_dstKeys;
+			ctx.m_dstKeys = keys;
+
+			uint32_t* values = ctx.m_srcValues;
+			ctx.m_srcValues = ctx.m_dstValues;
+			ctx.m_dstValues = values;
+		}
+
+		if (ctx.m_srcKeys != _keys)
+		{
+			memcpy(_keys, ctx.m_srcKeys, sizeof(T) * _count);
+			if (_values)
+				memcpy(_values, ctx.m_srcValues, sizeof(uint32_t) * _count);
+		}
+	}
+
+	/// 
+	void parallelSort(uint32_t* _keys, uint32_t _count, uint32_t* _values)
+	{
+		parallelRadixSort(_keys, _count, _values);
+	}
+
+	/// 
+	void parallelSort(uint64_t* _keys, uint32_t _count, uint32_t* _values)
+	{
+		parallelRadixSort(_keys, _count, _values);
+	}
+
+	static void parallelMerge(const uint8_t* _a, uint32_t _numA, const uint8_t* _b, uint32_t _numB, uint8_t* _dst, uint32_t _stride, LessFn _less, void* _userData)
+	{
+		while (_numA && _numB)
+		{
+			// take from second run only if strictly less, keeps the sort stable
+			if (_less(_b, _a, _userData))
+			{
+				memcpy(_dst, _b, _stride);
+				_b += _stride;
+				--_numB;
+			}
+			else
+			{
+				memcpy(_dst, _a, _stride);
+				_a += _stride;
+				--_numA;
+			}
+			_dst += _stride;
+		}
+
+		memcpy(_dst, _a, _numA * _stride);
+		memcpy(_dst + _numA * _stride, _b, _numB * _stride);
+	}
+
+	/// Serial merge sort, _temp has to be as large as _data.
+	static void parallelSortSerial(uint8_t* _data, uint8_t* _temp, uint32_t _count, uint32_t _stride, LessFn _less, void* _userData)
+	{
+		if (_count <= 16)
+		{
+			for (uint32_t i=1; i<_count; ++i)
+			{
+				memcpy(_temp, _data + i * _stride, _stride);
+
+				uint32_t j = i;
+				while (j && _less(_temp, _data + (j - 1) * _stride, _userData))
+				{
+					memcpy(_data + j * _stride, _data + (j - 1) * _stride, _stride);
+					--j;
+				}
+
+				memcpy(_data + j * _stride, _temp, _stride);
+			}
+			return;
+		}
+
+		uint32_t half = _count / 2;
+		parallelSortSerial(_data, _temp, half, _stride, _less, _userData);
+		parallelSortSerial(_data + half * _stride, _temp + half * _stride, _count - half, _stride, _less, _userData);
+
+		// runs already in order
+		if (!_less(_data + half * _stride, _data + (half - 1) * _stride, _userData))
+			return;
+
+		memcpy(_temp, _data, _count * _stride);
+		parallelMerge(_temp, half, _temp + half * _stride, _count - half, _data, _stride, _less, _userData);
+	}
+
+	struct ParallelMergeSort
+	{
+		uint8_t*	m_data;
+		uint8_t*	m_temp;
+		uint8_t*	m_src;
+		uint8_t*	m_dst;
+		uint32_t	m_stride;
+		uint32_t	m_count;
+		uint32_t	m_numBlocks;
+		uint32_t	m_width;		// run width in blocks for current merge pass
+		LessFn		m_less;
+		void*		m_userData;
+	};
+
+	static void parallelMergeSortBlock(void* _context, uint32_t _block, uint32_t _threadNum)
+	{
+		RTM_UNUSED(_threadNum);
+		ParallelMergeSort* ctx = (ParallelMergeSort*)_context;
+
+		uint32_t start, end;
+		parallelBlockRange(ctx->m_count, ctx->m_numBlocks, _block, start, end);
+		parallelSortSerial(ctx->m_data + start * ctx->m_stride, ctx->m_temp + start * ctx->m_stride, end - start, ctx->m_stride, ctx->m_less, ctx->m_userData);
+	}
+
+	static void parallelMergeSortMerge(void* _context, uint32_t _merge, uint32_t _threadNum)
+	{
+		RTM_UNUSED(_threadNum);
+		ParallelMergeSort* ctx = (ParallelMergeSort*)_context;
+
+		uint32_t firstBlock		= _merge * ctx->m_width * 2;
+		uint32_t middleBlock	= firstBlock + ctx->m_width;
+		uint32_t endBlock		= middleBlock + ctx->m_width;
+		if (middleBlock > ctx->m_numBlocks)	middleBlock	= ctx->m_numBlocks;
+		if (endBlock > ctx->m_numBlocks)	endBlock	= ctx->m_numBlocks;
+
+		uint32_t start, middle, end, unused;
+		parallelBlockRange(ctx->m_count, ctx->m_numBlocks, firstBlock, start, unused);
+		parallelBlockRange(ctx->m_count, ctx->m_numBlocks, middleBlock, middle, unused);
+		parallelBlockRange(ctx->m_count, ctx->m_numBlocks, endBlock, end, unused);
+
+		parallelMerge(	ctx->m_src + start * ctx->m_stride, middle - start,
+						ctx->m_src + middle * ctx->m_stride, end - middle,
+						ctx->m_dst + start * ctx->m_stride, ctx->m_stride, ctx->m_less, ctx->m_userData);
+	}
+
+	/// 
+	void parallelSort(void* _data, uint32_t _stride, uint32_t _count, LessFn _less, void* _userData)
+	{
+		if (_count < 2)
+			return;
+
+		ParallelMergeSort ctx;
+		ctx.m_data		= (uint8_t*)_data;
+		ctx.m_temp		= (uint8_t*)frameAlloc(_stride * _count);
+		ctx.m_stride	= _stride;
+		ctx.m_count		= _count;
+		ctx.m_numBlocks	= parallelNumBlocks(_count);
+		ctx.m_less		= _less;
+		ctx.m_userData	= _userData;
+
+		// no scratch, stable insertion sort swapping items in place
+		if (!ctx.m_temp)
+		{
+			for (uint32_t i=1; i<_count; ++i)
+				for (uint32_t j=i; j && _less(ctx.m_data + j * _stride, ctx.m_data + (j - 1) * _stride, _userData); --j)
+					parallelSwap(ctx.m_data + j * _stride, ctx.m_data + (j - 1) * _stride, _stride);
+			return;
+		}
+
+		parallelRun(ctx.m_numBlocks, parallelMergeSortBlock, &ctx);
+
+		ctx.m_src = ctx.m_data;
+		ctx.m_dst = ctx.m_temp;
+		for (ctx.m_width=1; ctx.m_width<ctx.m_numBlocks; ctx.m_width*=2)
+		{
+			uint32_t numMerges = (ctx.m_numBlocks + ctx.m_width * 2 - 1) / (ctx.m_width * 2);
+			parallelRun(numMerges, parallelMergeSortMerge, &ctx);
+
+			uint8_t* src = ctx.m_src;
+			ctx.m_src = ctx.m_dst;
+			ctx.m_dst = src;
+		}
+
+		if (ctx.m_src != ctx.m_data)
+			memcpy(ctx.m_data, ctx.m_src, _stride * _count);
+	}
+
+	struct ParallelPartition
+	{
+		uint8_t*		m_data;
+		uint8_t*		m_temp;
+		uint8_t*		m_flags;
+		uint32_t		m_stride;
+		uint32_t		m_count;
+		uint32_t		m_numBlocks;
+		uint32_t*		m_trueOffsets;	// per block count, then prefix
+		uint32_t*		m_falseOffsets;
+		PredicateFn		m_predicate;
+		void*			m_userData;
+	};
+
+	static void parallelPartitionCountBlock(void* _context, uint32_t _block, uint32_t _threadNum)
+	{
+		RTM_UNUSED(_threadNum);
+		ParallelPartition* ctx = (ParallelPartition*)_context;
+
+		uint32_t start, end;
+		parallelBlockRange(ctx->m_count, ctx->m_numBlocks, _block, start, end);
+
+		uint32_t numTrue = 0;
+		for (uint32_t i=start; i<end; ++i)
+		{
+			uint8_t flag = ctx->m_predicate(ctx->m_data + i * ctx->m_stride, ctx->m_userData) ? 1 : 0;
+			ctx->m_flags[i] = flag;
+			numTrue += flag;
+		}
+		ctx->m_trueOffsets[_block] = numTrue;
+	}
+
+	static void parallelPartitionScatterBlock(void* _context, uint32_t _block, uint32_t _threadNum)
+	{
+		RTM_UNUSED(_threadNum);
+		ParallelPartition* ctx = (ParallelPartition*)_context;
+
+		uint32_t start, end;
+		parallelBlockRange(ctx->m_count, ctx->m_numBlocks, _block, start, end);
+
+		uint32_t trueOffset		= ctx->m_trueOffsets[_block];
+		uint32_t falseOffset	= ctx->m_falseOffsets[_block];
+		for (uint32_t i=start; i<end; ++i)
+		{
+			uint32_t dst = ctx->m_flags[i] ? trueOffset++ : falseOffset++;
+			memcpy(ctx->m_temp + dst * ctx->m_stride, ctx->m_data + i * ctx->m_stride, ctx->m_stride);
+		}
+	}
+
+	static void parallelPartitionCopyBlock(void* _context, uint32_t _block, uint32_t _threadNum)
+	{
+		RTM_UNUSED(_threadNum);
+		ParallelPartition* ctx = (ParallelPartition*)_context;
+
+		uint32_t start, end;
+		parallelBlockRange(ctx->m_count, ctx->m_numBlocks, _block, start, end);
+		memcpy(ctx->m_data + start * ctx->m_stride, ctx->m_temp + start * ctx->m_stride, (end - start) * ctx->m_stride);
+	}
+
+	/// 
+	uint32_t parallelPartition(void* _data, uint32_t _stride, uint32_t _count, PredicateFn _predicate, void* _userData)
+	{
+		if (!_count)
+			return 0;
+
+		ParallelPartition ctx;
+		ctx.m_data			= (uint8_t*)_data;
+		ctx.m_stride		= _stride;
+		ctx.m_count			= _count;
+		ctx.m_numBlocks		= parallelNumBlocks(_count);
+		ctx.m_predicate		= _predicate;
+		ctx.m_userData		= _userData;
+
+		// offsets go first and are padded so items in temp stay aligned
+		uint32_t offsetsSize	= (sizeof(uint32_t) * 2 * ctx.m_numBlocks + 63) & ~63;
+		uint8_t* buffer			= (uint8_t*)frameAlloc(offsetsSize + _stride * _count + _count, 64);
+		if (!buffer)
+		{
+			// no scratch, stable partition moving each match down past preceding non matches
+			uint8_t* data = (uint8_t*)_data;
+			uint32_t numTrue = 0;
+			for (uint32_t i=0; i<_count; ++i)
+			{
+				if (!_predicate(data + i * _stride, _userData))
+					continue;
+
+				for (uint32_t j=i; j>numTrue; --j)
+					parallelSwap(data + j * _stride, data + (j - 1) * _stride, _stride);
+				++numTrue;
+			}
+			return numTrue;
+		}
+
+		ctx.m_trueOffsets	= (uint32_t*)buffer;
+		ctx.m_falseOffsets	= ctx.m_trueOffsets + ctx.m_numBlocks;
+		ctx.m_temp			= buffer + offsetsSize;
+		ctx.m_flags			= ctx.m_temp + _stride * _count;
+
+		parallelRun(ctx.m_numBlocks, parallelPartitionCountBlock, &ctx);
+
+		uint32_t numTrue = 0;
+		for (uint32_t i=0; i<ctx.m_numBlocks; ++i)
+		{
+			uint32_t count = ctx.m_trueOffsets[i];
+			ctx.m_trueOffsets[i] = numTrue;
+			numTrue += count;
+		}
+
+		// items not satisfying predicate before a block is its start minus preceding matches
+		for (uint32_t i=0; i<ctx.m_numBlocks; ++i)
+		{
+			uint32_t start, end;
+			parallelBlockRange(_count, ctx.m_numBlocks, i, start, end);
+			ctx.m_falseOffsets[i] = numTrue + start - ctx.m_trueOffsets[i];
+		}
+
+		parallelRun(ctx.m_numBlocks, parallelPartitionScatterBlock, &ctx);
+		parallelRun(ctx.m_numBlocks, parallelPartitionCopyBlock, &ctx);
+
+		return numTrue;
 	}
 
 } // namespace rapp
@@ -11,12 +11,71 @@
 
 namespace rapp {
 
+	/// Scheduler slot of the timer thread, not a valid thread to pin tasks to.
+	#define RAPP_TASK_THREAD_TIMER		0xfffffffd
+
+	/// Scheduler slot of the file completion thread, not a valid thread to pin tasks to.
+	#define RAPP_TASK_THREAD_FILE		0xfffffffb
+
 	///
-	void taskInit();
+	void taskInit(const TaskConfig* _config);
 
 	///
 	void taskShutdown();
 
+	/// Runs tasks pinned to the calling thread, registers the thread with scheduler on first call.
+	/// Called from platform main loop (RAPP_TASK_THREAD_MAIN) and app thread (RAPP_TASK_THREAD_APP).
+	void taskRunPinned(uint32_t _thread);
+
+	/// Registers calling thread with scheduler so it can submit and wait on tasks.
+	bool taskRegisterThread(uint32_t _thread);
+
+	/// Unregisters calling thread registered with taskRegisterThread.
+	void taskUnregisterThread();
+
+	/// Creates a task that is run later by taskRun from an external event, e.g. file read completion.
+	/// Task is deleted on finish, taskWait on it blocks until it's launched and finished.
+	TaskHandle taskCreateDeferred(TaskFn _func, void* _userData, const char* _name);
+
+	/// Marks a task created by the framework as internal, internal tasks ignore taskCancel, deadlines
+	/// and taskCancelAll. Deferred tasks are internal. Has to be called before the task is run.
+	void taskSetInternal(TaskHandle _task);
+
+	/// Ends the frame, arenas of the frame RAPP_FRAME_ARENA_FRAMES - 1 frames back are recycled on
+	/// their owner thread's next allocation.
+	void frameAdvance();
+
+	/// Returns index of the current frame, incremented by frameAdvance.
+	uint32_t frameGetIndex();
+
+	/// Starts timer thread, called after task system is initialized.
+	void timerInit();
+
+	/// Stops timer thread, pending timers are dropped.
+	void timerShutdown();
+
+	/// Fires frame timers that are due, called from frameAdvance.
+	void timerFrameAdvance();
+
+	/// Starts asynchronous file reading backend, called after task system is initialized.
+	void fileInit();
+
+	/// Stops asynchronous file reading backend, waits for reads in flight and their callbacks to finish.
+	void fileShutdown();
+
+	/// Returns true if there are completion callbacks waiting to be called on app thread.
+	bool taskHasAppCallbacks();
+
+	/// Calls completion callbacks queued by taskThenOnAppThread, called from app thread.
+	void taskRunAppCallbacks();
+
+	/// Sets function used to wake up main thread once a task is pinned to it, must be thread safe.
+	/// Platforms that don't set it fall back to appRunOnMainThread.
+	void taskSetMainThreadWake(ThreadFn _fn, void* _userData);
+
+	/// Sets function used to wake up app thread once a task is pinned to it or an app callback is queued, must be thread safe.
+	void taskSetAppThreadWake(ThreadFn _fn, void* _userData);
+
 } // namespace rapp
 
 #endif // RTM_RAPP_TASK_H
@@ -0,0 +1,465 @@
+//--------------------------------------------------------------------------//
+/// Copyright 2025 Milos Tosic. All Rights Reserved.                       ///
+/// License: http://www.opensource.org/licenses/BSD-2-Clause               ///
+//--------------------------------------------------------------------------//
+
+#include <rapp_pch.h>
+#include <rapp/src/rapp_config.h>
+#include <rapp/src/rapp_timer.h>
+#include <rapp/src/task_private.h>
+
+#include <rbase/inc/thread.h>
+
+#include <condition_variable>
+#include <mutex>
+
+namespace rapp {
+
+	#define RAPP_TIMER_SLOTS		(1 << RAPP_TIMER_WHEEL_BITS)
+	#define RAPP_TIMER_SLOT_MASK	(RAPP_TIMER_SLOTS - 1)
+	#define RAPP_TIMER_RANGE		(1ULL << (RAPP_TIMER_WHEEL_BITS * RAPP_TIMER_WHEEL_LEVELS))
+	#define RAPP_TIMER_NONE			UINT32_MAX
+
+	#define RAPP_TIMER_WHEEL_TIME	0
+	#define RAPP_TIMER_WHEEL_FRAME	1
+
+	struct TimerState
+	{
+		enum Enum : uint8_t
+		{
+			Free,
+			Pending,
+			Firing
+		};
+	};
+
+	struct Timer
+	{
+		uint64_t	m_expires;
+		uint64_t	m_period;		// in wheel ticks, 0 for one shot timers
+		TaskFn		m_function;
+		void*		m_userData;
+		const char*	m_name;
+		uint32_t	m_next;
+		uint32_t	m_prev;
+		uint16_t	m_slot;			// level * RAPP_TIMER_SLOTS + slot
+		uint16_t	m_generation;
+		TimerState::Enum	m_state;
+		uint8_t		m_wheel;
+		bool		m_cancelled;
+	};
+
+	/// Hierarchical timer wheel, level 0 slots are one tick apart and each next level
+	/// covers RAPP_TIMER_SLOTS times longer span. Timers are cascaded to lower levels
+	/// as time reaches their slot.
+	struct TimerWheel
+	{
+		uint64_t	m_now;
+		uint64_t	m_occupied[RAPP_TIMER_WHEEL_LEVELS];
+		uint32_t	m_slots[RAPP_TIMER_WHEEL_LEVELS][RAPP_TIMER_SLOTS];
+		uint32_t	m_count;
+	};
+
+	static Timer					s_timers[RAPP_TIMER_MAX];
+	static uint32_t					s_timerFree;
+	static TimerWheel				s_timerWheels[2];
+	static std::mutex				s_timerLock;
+	static std::condition_variable	s_timerWake;
+	static uint64_t					s_timerWakeTick;
+	static bool						s_timerRunning = false;
+	static TickClock				s_timerClock(RAPP_TIMER_TICK_US);
+	static std::atomic<uint32_t>	s_timerFramePending(0);
+	static std::atomic<uint64_t>	s_timerFrame(0);
+	static rtm::Thread				s_timerThread;
+	static thread_local bool		s_timerRunInline = false;
+
+	static void timerWheelInit(TimerWheel& _wheel, uint64_t _now)
+	{
+		_wheel.m_now	= _now;
+		_wheel.m_count	= 0;
+		for (uint32_t l=0; l<RAPP_TIMER_WHEEL_LEVELS; ++l)
+		{
+			_wheel.m_occupied[l] = 0;
+			for (uint32_t s=0; s<RAPP_TIMER_SLOTS; ++s)
+				_wheel.m_slots[l][s] = RAPP_TIMER_NONE;
+		}
+	}
+
+	static void timerLink(TimerWheel& _wheel, uint32_t _index)
+	{
+		Timer& timer = s_timers[_index];
+
+		uint64_t expires = timer.m_expires > _wheel.m_now ? timer.m_expires : _wheel.m_now + 1;
+		uint64_t delta = expires - _wheel.m_now;
+
+		// timers beyond the wheel range are parked in the last slot reachable and linked again when cascaded
+		if (delta >= RAPP_TIMER_RANGE)
+		{
+			delta	= RAPP_TIMER_RANGE - 1;
+			expires	= _wheel.m_now + delta;
+		}
+
+		uint32_t level = 0;
+		while ((level < RAPP_TIMER_WHEEL_LEVELS - 1) && (delta >= (1ULL << (RAPP_TIMER_WHEEL_BITS * (level + 1)))))
+			++level;
+
+		uint32_t slot = (uint32_t)(expires >> (RAPP_TIMER_WHEEL_BITS * level)) & RAPP_TIMER_SLOT_MASK;
+		uint32_t& head = _wheel.m_slots[level][slot];
+
+		timer.m_slot	= (uint16_t)(level * RAPP_TIMER_SLOTS + slot);
+		timer.m_prev	= RAPP_TIMER_NONE;
+		timer.m_next	= head;
+		if (head != RAPP_TIMER_NONE)
+			s_timers[head].m_prev = _index;
+		head = _index;
+
+		_wheel.m_occupied[level] |= 1ULL << slot;
+	}
+
+	static void timerUnlink(TimerWheel& _wheel, uint32_t _index)
+	{
+		Timer& timer = s_timers[_index];
+		uint32_t level	= timer.m_slot / RAPP_TIMER_SLOTS;
+		uint32_t slot	= timer.m_slot & RAPP_TIMER_SLOT_MASK;
+
+		if (timer.m_prev != RAPP_TIMER_NONE)
+			s_timers[timer.m_prev].m_next = timer.m_next;
+		else
+			_wheel.m_slots[level][slot] = timer.m_next;
+
+		if (timer.m_next != RAPP_TIMER_NONE)
+			s_timers[timer.m_next].m_prev = timer.m_prev;
+
+		if (_wheel.m_slots[level][slot] == RAPP_TIMER_NONE)
+			_wheel.m_occupied[level] &= ~(1ULL << slot);
+	}
+
+	static uint32_t timerDetachSlot(TimerWheel& _wheel, uint32_t _level, uint32_t _slot)
+	{
+		uint32_t head = _wheel.m_slots[_level][_slot];
+		_wheel.m_slots[_level][_slot]	 = RAPP_TIMER_NONE;
+		_wheel.m_occupied[_level]		&= ~(1ULL << _slot);
+		return head;
+	}
+
+	/// Moves a detached timer to the firing list.
+	static void timerDue(TimerWheel& _wheel, uint32_t _index, uint32_t& _firing)
+	{
+		Timer& timer = s_timers[_index];
+		timer.m_state	= TimerState::Firing;
+		timer.m_next	= _firing;
+		_firing			= _index;
+		--_wheel.m_count;
+	}
+
+	/// Advances wheel to a given tick, due timers are appended to the firing list.
+	static void timerAdvance(TimerWheel& _wheel, uint64_t _to, uint32_t& _firing)
+	{
+		if (!_wheel.m_count)
+		{
+			if (_to > _wheel.m_now)
+				_wheel.m_now = _to;
+			return;
+		}
+
+		while (_wheel.m_now < _to)
+		{
+			uint64_t now = ++_wheel.m_now;
+
+			// cascade higher levels when lower level wraps around
+			for (uint32_t l=1; l<RAPP_TIMER_WHEEL_LEVELS; ++l)
+			{
+				if (now & ((1ULL << (RAPP_TIMER_WHEEL_BITS * l)) - 1))
+					break;
+
+				uint32_t slot = (uint32_t)(now >> (RAPP_TIMER_WHEEL_BITS * l)) & RAPP_TIMER_SLOT_MASK;
+				uint32_t index = timerDetachSlot(_wheel, l, slot);
+				while (index != RAPP_TIMER_NONE)
+				{
+					uint32_t next = s_timers[index].m_next;
+
+					// due timers fire on this tick, relinking would push them to the next one
+					if (s_timers[index].m_expires <= now)
+						timerDue(_wheel, index, _firing);
+					else
+						timerLink(_wheel, index);
+
+					index = next;
+				}
+			}
+
+			uint32_t index = timerDetachSlot(_wheel, 0, (uint32_t)now & RAPP_TIMER_SLOT_MASK);
+			while (index != RAPP_TIMER_NONE)
+			{
+				uint32_t next = s_timers[index].m_next;
+				timerDue(_wheel, index, _firing);
+				index = next;
+			}
+		}
+	}
+
+	/// Number of ticks until the next level 0 slot with timers or the next cascade, whichever comes first.
+	static uint64_t timerTicksToNext(const TimerWheel& _wheel)
+	{
+		uint32_t current = (uint32_t)_wheel.m_now & RAPP_TIMER_SLOT_MASK;
+		uint64_t ticks = RAPP_TIMER_SLOTS - current;
+
+		uint64_t occupied = _wheel.m_occupied[0];
+		for (uint32_t i=1; occupied && (i<ticks); ++i)
+			if (occupied & (1ULL << ((current + i) & RAPP_TIMER_SLOT_MASK)))
+				return i;
+		return ticks;
+	}
+
+	static void timerFree(uint32_t _index)
+	{
+		Timer& timer = s_timers[_index];
+		timer.m_state		= TimerState::Free;
+		timer.m_generation	= (uint16_t)(timer.m_generation + 1);
+		timer.m_next		= s_timerFree;
+		s_timerFree			= _index;
+	}
+
+	/// Submits tasks of fired timers, periodic timers are linked back into the wheel.
+	/// Called with lock held, lock is released while submitting.
+	static void timerFire(uint32_t _firing, std::unique_lock<std::mutex>& _lock)
+	{
+		if (_firing == RAPP_TIMER_NONE)
+			return;
+
+		// fields of firing timers are only changed by the firing thread, cancel just flags them
+		_lock.unlock();
+		for (uint32_t index=_firing; index != RAPP_TIMER_NONE; index = s_timers[index].m_next)
+		{
+			Timer& timer = s_timers[index];
+
+			TaskHandle task = s_timerRunInline ? TaskHandle{ UINT32_MAX } : taskCreate(timer.m_function, timer.m_userData, true, timer.m_name);
+			if (!isValid(task))
+			{
+				// task pool exhausted or no scheduler access, run on firing thread rather than drop
+				timer.m_function(timer.m_userData, 0, 1);
+				continue;
+			}
+
+			taskRun(task);
+		}
+		_lock.lock();
+
+		uint32_t index = _firing;
+		while (index != RAPP_TIMER_NONE)
+		{
+			Timer& timer = s_timers[index];
+			uint32_t next = timer.m_next;
+
+			if (timer.m_period && !timer.m_cancelled)
+			{
+				TimerWheel& wheel = s_timerWheels[timer.m_wheel];
+				// re-arm from now when behind, missed periods are skipped rather than fired in a burst
+				timer.m_expires	+= timer.m_period;
+				if (timer.m_expires <= wheel.m_now)
+					timer.m_expires = wheel.m_now + timer.m_period;
+				timer.m_state	 = TimerState::Pending;
+				timerLink(wheel, index);
+				++wheel.m_count;
+			}
+			else
+				timerFree(index);
+
+			index = next;
+		}
+	}
+
+	static int32_t timerThreadFunc(void* _userData)
+	{
+		RTM_UNUSED(_userData);
+
+		bool registered = taskRegisterThread(RAPP_TASK_THREAD_TIMER);
+		RTM_ASSERT(registered, "Timer thread failed to register with task scheduler, timers will run inline!");
+		s_timerRunInline = !registered;
+
+		TimerWheel& wheel = s_timerWheels[RAPP_TIMER_WHEEL_TIME];
+
+		std::unique_lock<std::mutex> lock(s_timerLock);
+		while (s_timerRunning)
+		{
+			uint32_t firing = RAPP_TIMER_NONE;
+			timerAdvance(wheel, s_timerClock.ticks(), firing);
+			timerFire(firing, lock);
+
+			if (!wheel.m_count)
+			{
+				s_timerWakeTick = UINT64_MAX;
+				s_timerWake.wait(lock);
+				continue;
+			}
+
+			uint64_t ticks = timerTicksToNext(wheel);
+			s_timerWakeTick = wheel.m_now + ticks;
+			s_timerWake.wait_for(lock, std::chrono::microseconds(ticks * s_timerClock.tickUs()));
+		}
+		lock.unlock();
+
+		if (registered)
+			taskUnregisterThread();
+		return 0;
+	}
+
+	static TimerHandle timerAdd(uint32_t _wheel, uint64_t _delay, uint64_t _period, TaskFn _func, void* _userData, const char* _name)
+	{
+		RTM_ASSERT(_func, "Timer needs a task function!");
+
+		std::unique_lock<std::mutex> lock(s_timerLock);
+
+		uint32_t index = s_timerFree;
+		RTM_ASSERT(index != RAPP_TIMER_NONE, "Timer pool exhausted, increase RAPP_TIMER_MAX!");
+		if (index == RAPP_TIMER_NONE)
+			return { UINT32_MAX };
+
+		TimerWheel& wheel = s_timerWheels[_wheel];
+
+		// idle wheels aren't advanced, catch up before computing expiry
+		uint64_t now = _wheel == RAPP_TIMER_WHEEL_TIME ? s_timerClock.ticks() : s_timerFrame.load(std::memory_order_relaxed);
+		if (!wheel.m_count && (now > wheel.m_now))
+			wheel.m_now = now;
+
+		Timer& timer = s_timers[index];
+		s_timerFree = timer.m_next;
+
+		timer.m_expires		= now + (_delay ? _delay : 1);
+		timer.m_period		= _period;
+		timer.m_function	= _func;
+		timer.m_userData	= _userData;
+		timer.m_name		= _name;
+		timer.m_state		= TimerState::Pending;
+		timer.m_wheel		= (uint8_t)_wheel;
+		timer.m_cancelled	= false;
+
+		timerLink(wheel, index);
+		++wheel.m_count;
+
+		if (_wheel == RAPP_TIMER_WHEEL_FRAME)
+			s_timerFramePending.store(wheel.m_count, std::memory_order_relaxed);
+		else
+		if (timer.m_expires < s_timerWakeTick)
+			s_timerWake.notify_one();
+
+		return { ((uint32_t)timer.m_generation << 16) | index };
+	}
+
+	///
+	void timerInit()
+	{
+		s_timerFree = RAPP_TIMER_NONE;
+		for (uint32_t i=RAPP_TIMER_MAX; i>0; --i)
+		{
+			Timer& timer = s_timers[i - 1];
+			timer.m_state		= TimerState::Free;
+			timer.m_generation	= 0;
+			timer.m_next		= s_timerFree;
+			s_timerFree			= i - 1;
+		}
+
+		timerWheelInit(s_timerWheels[RAPP_TIMER_WHEEL_TIME], s_timerClock.ticks());
+		timerWheelInit(s_timerWheels[RAPP_TIMER_WHEEL_FRAME], s_timerFrame.load());
+		s_timerWakeTick	= UINT64_MAX;
+		s_timerRunning	= true;
+
+#if !RTM_PLATFORM_EMSCRIPTEN
+		s_timerThread.start(timerThreadFunc, 0, 0, "Timer");
+#endif // !RTM_PLATFORM_EMSCRIPTEN
+	}
+
+	///
+	void timerShutdown()
+	{
+		{
+			std::unique_lock<std::mutex> lock(s_timerLock);
+			s_timerRunning = false;
+			s_timerWake.notify_one();
+		}
+
+#if !RTM_PLATFORM_EMSCRIPTEN
+		s_timerThread.stop();
+#endif // !RTM_PLATFORM_EMSCRIPTEN
+	}
+
+	///
+	void timerFrameAdvance()
+	{
+		uint64_t frame = s_timerFrame.fetch_add(1, std::memory_order_relaxed) + 1;
+
+#if RTM_PLATFORM_EMSCRIPTEN
+		// no timer thread, time wheel is polled once per frame
+		{
+			std::unique_lock<std::mutex> lock(s_timerLock);
+			uint32_t firing = RAPP_TIMER_NONE;
+			timerAdvance(s_timerWheels[RAPP_TIMER_WHEEL_TIME], s_timerClock.ticks(), firing);
+			timerFire(firing, lock);
+		}
+#endif // RTM_PLATFORM_EMSCRIPTEN
+
+		if (!s_timerFramePending.load(std::memory_order_relaxed))
+			return;
+
+		std::unique_lock<std::mutex> lock(s_timerLock);
+		TimerWheel& wheel = s_timerWheels[RAPP_TIMER_WHEEL_FRAME];
+
+		uint32_t firing = RAPP_TIMER_NONE;
+		timerAdvance(wheel, frame, firing);
+		timerFire(firing, lock);
+		s_timerFramePending.store(wheel.m_count, std::memory_order_relaxed);
+	}
+
+	///
+	TimerHandle taskRunAfter(float _delay, TaskFn _func, void* _userData, const char* _name)
+	{
+		return timerAdd(RAPP_TIMER_WHEEL_TIME, s_timerClock.toTicks(_delay), 0, _func, _userData, _name);
+	}
+
+	///
+	TimerHandle taskRunEvery(float _period, TaskFn _func, void* _userData, const char* _name)
+	{
+		uint64_t period = s_timerClock.toTicks(_period);
+		period = period ? period : 1;
+		return timerAdd(RAPP_TIMER_WHEEL_TIME, period, period, _func, _userData, _name);
+	}
+
+	///
+	TimerHandle taskRunInFrames(uint32_t _frames, TaskFn _func, void* _userData, const char* _name)
+	{
+		return timerAdd(RAPP_TIMER_WHEEL_FRAME, _frames, 0, _func, _userData, _name);
+	}
+
+	///
+	bool timerCancel(TimerHandle _timer)
+	{
+		uint32_t index = _timer.idx & 0xffff;
+		if (index >= RAPP_TIMER_MAX)
+			return false;
+
+		std::unique_lock<std::mutex> lock(s_timerLock);
+
+		Timer& timer = s_timers[index];
+		if ((timer.m_generation != (_timer.idx >> 16)) || (timer.m_state == TimerState::Free))
+			return false;
+
+		// firing timer is released by the firing thread, one shot timers have already been submitted
+		if (timer.m_state == TimerState::Firing)
+		{
+			bool wasPending = timer.m_period && !timer.m_cancelled;
+			timer.m_cancelled = true;
+			return wasPending;
+		}
+
+		TimerWheel& wheel = s_timerWheels[timer.m_wheel];
+		timerUnlink(wheel, index);
+		--wheel.m_count;
+
+		if (timer.m_wheel == RAPP_TIMER_WHEEL_FRAME)
+			s_timerFramePending.store(wheel.m_count, std::memory_order_relaxed);
+
+		timerFree(index);
+		return true;
+	}
+
+} // namespace rapp